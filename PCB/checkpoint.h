@@ -0,0 +1,175 @@
+//
+//  checkpoint.h
+//  PCB
+//  CSCI 340 Project
+//
+//  Versioned binary checkpoint files, written in one go and read back through mmap
+//
+
+#ifndef checkpoint_h
+#define checkpoint_h
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+ Checkpoint layout
+
+ header   "OSCK", uint32 version, uint32 number of sections, uint32 0
+ section  uint32 id, uint32 element size, uint64 element count,
+          then count raw elements padded to 8 bytes
+ Elements are plain structs and arrays in host byte order, so a checkpoint
+ is only read back by the same build on the same kind of machine
+ Every section starts 8 byte aligned, so the mapped file is used in place
+ */
+struct checkpoint_file_header {
+    char magic[4];
+    uint32_t version, sections, reserved;
+};
+struct checkpoint_section_header {
+    uint32_t id, element_size;
+    uint64_t count;
+};
+
+/*
+ checkpoint_writer
+
+ Collects sections in one buffer and writes the file with a single write call
+ */
+class checkpoint_writer {
+    std::vector<char> buffer;
+    uint32_t sections = 0;
+
+public:
+    checkpoint_writer(uint32_t version) {
+        checkpoint_file_header header = {{'O', 'S', 'C', 'K'}, version, 0, 0};
+        buffer.assign(reinterpret_cast<const char*>(&header), reinterpret_cast<const char*>(&header) + sizeof(header));
+    }
+    template <class type>
+    void section(uint32_t id, const type* data, size_t count) {
+        checkpoint_section_header header = {id, (uint32_t)sizeof(type), count};
+        buffer.insert(buffer.end(), reinterpret_cast<const char*>(&header), reinterpret_cast<const char*>(&header) + sizeof(header));
+        buffer.insert(buffer.end(), reinterpret_cast<const char*>(data), reinterpret_cast<const char*>(data) + count*sizeof(type));
+        buffer.resize((buffer.size() + 7) & ~(size_t)7, 0);
+        sections++;
+    }
+    template <class type>
+    void section(uint32_t id, const std::vector<type>& data) {
+        section(id, data.data(), data.size());
+    }
+    //Write the file, returns false if it cannot be written completely
+    bool write(const char* file_name) {
+        std::memcpy(&buffer[offsetof(checkpoint_file_header, sections)], &sections, sizeof(sections));
+        int fd = ::open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0)
+            return false;
+        ssize_t written = ::write(fd, buffer.data(), buffer.size());
+        bool complete = written == (ssize_t)buffer.size();
+        return ::close(fd) == 0 && complete;
+    }
+};
+
+/*
+ checkpoint_reader
+
+ Maps a checkpoint read only and finds its sections
+ Section data points into the mapping, which lives as long as the reader
+ */
+class checkpoint_reader {
+    void* mapping = MAP_FAILED;
+    size_t length = 0;
+    uint32_t file_version = 0;
+    struct entry {
+        uint32_t id, element_size;
+        uint64_t count;
+        const char* data;
+    };
+    std::vector<entry> entries;
+
+public:
+    ~checkpoint_reader() {
+        if(mapping != MAP_FAILED)
+            munmap(mapping, length);
+    }
+    //Map file and index its sections, returns false if it is not a checkpoint
+    bool open(const char* file_name) {
+        int fd = ::open(file_name, O_RDONLY);
+        if(fd < 0)
+            return false;
+        struct stat info;
+        if(fstat(fd, &info) == 0 && info.st_size >= (off_t)sizeof(checkpoint_file_header)) {
+            length = (size_t)info.st_size;
+            mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if(mapping == MAP_FAILED)
+            return false;
+        const char* begin = static_cast<const char*>(mapping);
+        const checkpoint_file_header* header = reinterpret_cast<const checkpoint_file_header*>(begin);
+        if(std::memcmp(header->magic, "OSCK", 4) != 0)
+            return false;
+        file_version = header->version;
+        size_t offset = sizeof(checkpoint_file_header);
+        for (uint32_t i = 0; i < header->sections; i++) {
+            if(length - offset < sizeof(checkpoint_section_header))
+                return false;
+            const checkpoint_section_header* section = reinterpret_cast<const checkpoint_section_header*>(begin + offset);
+            offset += sizeof(checkpoint_section_header);
+            if(section->element_size && section->count > (length - offset) / section->element_size)
+                return false;
+            entry e = {section->id, section->element_size, section->count, begin + offset};
+            entries.push_back(e);
+            //The padding after the last section may be cut off with the rest of the file
+            offset = (offset + section->count*section->element_size + 7) & ~(size_t)7;
+            if(offset > length)
+                return false;
+        }
+        return true;
+    }
+    uint32_t version() const {
+        return file_version;
+    }
+    //Elements of section id, false if it is missing or holds another type
+    template <class type>
+    bool get(uint32_t id, const type*& data, size_t& count) const {
+        for (size_t i = 0; i < entries.size(); i++) {
+            if(entries[i].id == id) {
+                if(entries[i].element_size != sizeof(type))
+                    return false;
+                data = reinterpret_cast<const type*>(entries[i].data);
+                count = (size_t)entries[i].count;
+                return true;
+            }
+        }
+        return false;
+    }
+    //Copy section id into vector in one go
+    template <class type>
+    bool get(uint32_t id, std::vector<type>& data) const {
+        const type* elements;
+        size_t count;
+        if(!get(id, elements, count))
+            return false;
+        data.assign(elements, elements + count);
+        return true;
+    }
+    //Single element section
+    template <class type>
+    bool get(uint32_t id, type& value) const {
+        const type* elements;
+        size_t count;
+        if(!get(id, elements, count) || count != 1)
+            return false;
+        value = *elements;
+        return true;
+    }
+};
+
+#endif /* checkpoint_h */
@@ -0,0 +1,64 @@
+//
+//  device.h
+//  PCB
+//  CSCI 340 Project
+//
+//  Timing model for printers and disks
+//
+
+#ifndef device_h
+#define device_h
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+enum device_kind : unsigned char {printer_device, disk_device};
+
+//Ticks to serve file_size at rate units per tick, at least one tick
+inline unsigned long long service_time(unsigned int file_size, unsigned int rate) {
+    unsigned long long ticks = (file_size + (unsigned long long)rate - 1) / rate;
+    return ticks > 0 ? ticks : 1;
+}
+
+/*
+ device_stats
+
+ Counters for one timed device
+ wait is from queueing to start of service, response is from queueing to completion
+ */
+struct device_stats {
+    unsigned long long requests = 0, completed = 0;
+    unsigned long long busy_time = 0, wait_time = 0, response_time = 0;
+    //Time the request at the head of the queue started service
+    unsigned long long service_start = 0;
+
+    void print(std::ostream& out, const std::string& name, unsigned long long elapsed) const {
+        std::ios::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+        out << std::setw(15) << std::left << name
+        << std::setw(10) << std::left << requests
+        << std::setw(10) << std::left << completed
+        << std::setw(8) << std::left << std::fixed << std::setprecision(3)
+        << (elapsed ? (double)busy_time / elapsed : 0.0)
+        << std::setw(10) << std::left << std::setprecision(2)
+        << (completed ? (double)wait_time / completed : 0.0)
+        << std::setw(10) << std::left
+        << (completed ? (double)response_time / completed : 0.0)
+        << std::setprecision(4)
+        << (elapsed ? (double)completed / elapsed : 0.0) << '\n';
+        out.flags(flags);
+        out.precision(precision);
+    }
+    static void print_header(std::ostream& out) {
+        out << std::setw(15) << std::left << "Device"
+        << std::setw(10) << std::left << "Requests"
+        << std::setw(10) << std::left << "Done"
+        << std::setw(8) << std::left << "Util"
+        << std::setw(10) << std::left << "Avg wait"
+        << std::setw(10) << std::left << "Avg resp"
+        << "Throughput" << '\n';
+    }
+};
+
+#endif /* device_h */
@@ -0,0 +1,230 @@
+//
+//  disk.h
+//  PCB
+//  CSCI 340 Project
+//
+//  Disk request queues ordered by a disk scheduling policy
+//
+
+#ifndef disk_h
+#define disk_h
+
+#include <set>
+#include <vector>
+#include <string>
+#include "process.h"
+
+enum disk_scheduling {fcfs_disk, sstf_disk, scan_disk, clook_disk};
+
+//Name of disk scheduling policy
+inline const char* disk_scheduling_name(disk_scheduling policy) {
+    const char* names[] = {"fcfs", "sstf", "scan", "clook"};
+    return names[policy];
+}
+//Read disk scheduling policy name, returns false if it is not one
+inline bool parse_disk_scheduling(const char* s, size_t n, disk_scheduling& policy) {
+    for (int i = 0; i < 4; i++) {
+        const char* name = disk_scheduling_name((disk_scheduling)i);
+        if(std::char_traits<char>::length(name) == n && std::char_traits<char>::compare(name, s, n) == 0) {
+            policy = (disk_scheduling)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+//Cylinder a file lives on when a request does not name one, same file same cylinder
+inline unsigned int file_cylinder(const char* name, size_t n, unsigned int cylinders) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < n; i++)
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    return cylinders ? hash % cylinders : 0;
+}
+
+//Ticks the head takes to move distance cylinders at rate cylinders per tick, 0 for instant seeks
+inline unsigned long long seek_time(unsigned long long distance, unsigned int rate) {
+    return rate ? (distance + rate - 1) / rate : 0;
+}
+
+/*
+ disk
+
+ Requests for one disk and the position of its head
+ The request being served is picked as soon as the previous one completes,
+ so front is always the one a D interrupt or a timed completion finishes
+ Waiting requests are kept in a std::set so every pick is O(log n)
+ fcfs   order of arrival
+ sstf   closest cylinder to the head, ties go up
+ scan   elevator, sweeps to the last cylinder in one direction before it turns around
+ clook  only serves on the way up, then jumps back to the lowest waiting cylinder
+ Requests on the same cylinder are served oldest first under every policy
+ Head travel, including the turn at the edge of scan and the jump back of clook,
+ counts toward seek distance and the seek time of the request it leads to
+ */
+class disk {
+    struct request {
+        //Cylinder, or 0 for fcfs so requests are ordered by sequence alone
+        unsigned int position;
+        unsigned long long sequence;
+        process_handle h;
+        unsigned int cylinder;
+
+        bool operator<(const request& other) const {
+            return position < other.position || (position == other.position && sequence < other.sequence);
+        }
+    };
+    disk_scheduling policy;
+    unsigned int cylinders;
+    std::set<request> waiting;
+    request serving;
+    unsigned int head = 0;
+    bool up = true;
+    unsigned long long sequence = 0;
+    //Travel to the edge on a scan turn, added to the seek of the request served next
+    unsigned long long turn = 0;
+
+    //Oldest waiting request on the cylinder of i
+    std::set<request>::iterator oldest(std::set<request>::iterator i) {
+        request at = {i->position, 0, no_process, 0};
+        return waiting.lower_bound(at);
+    }
+    //Waiting request the policy serves next
+    std::set<request>::iterator pick() {
+        request at = {head, 0, no_process, 0};
+        std::set<request>::iterator above = waiting.lower_bound(at);
+        switch (policy) {
+            case sstf_disk: {
+                if(above == waiting.begin())
+                    return above;
+                std::set<request>::iterator below = above;
+                below--;
+                if(above == waiting.end() || head - below->cylinder < above->cylinder - head)
+                    return oldest(below);
+                return above;
+            }
+            case scan_disk: {
+                at.sequence = ~0ull;
+                std::set<request>::iterator below = waiting.upper_bound(at);
+                if(up && above == waiting.end()) {
+                    //Run to the last cylinder and turn around
+                    turn = cylinders-1 - head;
+                    head = cylinders-1;
+                    up = false;
+                    below = waiting.end();
+                }
+                else if(!up && below == waiting.begin()) {
+                    turn = head;
+                    head = 0;
+                    up = true;
+                    above = waiting.begin();
+                }
+                if(up)
+                    return above;
+                return oldest(--below);
+            }
+            case clook_disk:
+                return above == waiting.end() ? waiting.begin() : above;
+            default:
+                return waiting.begin();
+        }
+    }
+    //Start serving r and move the head to it
+    void serve(const request& r) {
+        serving = r;
+        last_seek = turn + (r.cylinder > head ? r.cylinder - head : head - r.cylinder);
+        seek_distance += last_seek;
+        turn = 0;
+        head = r.cylinder;
+    }
+
+public:
+    //Head, counters and queue of a disk for checkpoints
+    struct state {
+        uint64_t last_seek, seek_distance, served, latency, sequence;
+        uint32_t head, up, requests, pad;
+    };
+    struct saved_request {
+        uint64_t sequence;
+        uint32_t h, cylinder;
+    };
+
+    //Head travel of the request being served, all head travel, requests completed and their time from queueing to completion
+    unsigned long long last_seek = 0, seek_distance = 0, served = 0, latency = 0;
+
+    disk(disk_scheduling policy = fcfs_disk, unsigned int cylinders = 200) : policy(policy), cylinders(cylinders ? cylinders : 1) {
+        serving.h = no_process;
+    }
+    bool empty() const {
+        return serving.h == no_process;
+    }
+    size_t size() const {
+        return waiting.size() + !empty();
+    }
+    //Request being served
+    process_handle front() const {
+        return serving.h;
+    }
+    unsigned int head_position() const {
+        return head;
+    }
+    //Queue request of h for cylinder, an idle disk starts on it right away
+    void push(process_handle h, unsigned int cylinder) {
+        request r = {policy == fcfs_disk ? 0 : cylinder, sequence++, h, cylinder};
+        if(empty())
+            serve(r);
+        else
+            waiting.insert(r);
+    }
+    //Finish the request being served and pick the next one
+    void pop() {
+        serving.h = no_process;
+        if(waiting.empty())
+            return;
+        std::set<request>::iterator next = pick();
+        serve(*next);
+        waiting.erase(next);
+    }
+    //Append the request being served, then the waiting ones, to requests
+    void save(state& s, std::vector<saved_request>& requests) const {
+        s.last_seek = last_seek;
+        s.seek_distance = seek_distance;
+        s.served = served;
+        s.latency = latency;
+        s.sequence = sequence;
+        s.head = head;
+        s.up = up;
+        s.requests = (uint32_t)size();
+        s.pad = 0;
+        if(!empty())
+            requests.push_back(saved_request{serving.sequence, serving.h, serving.cylinder});
+        for (std::set<request>::const_iterator i = waiting.begin(); i != waiting.end(); i++)
+            requests.push_back(saved_request{i->sequence, i->h, i->cylinder});
+    }
+    //Restore an empty disk from s and its s.requests saved requests
+    void load(const state& s, const saved_request* requests) {
+        for (uint32_t i = 0; i < s.requests; i++) {
+            request r = {policy == fcfs_disk ? 0 : requests[i].cylinder, requests[i].sequence, requests[i].h, requests[i].cylinder};
+            if(i == 0)
+                serving = r;
+            else
+                waiting.insert(r);
+        }
+        last_seek = s.last_seek;
+        seek_distance = s.seek_distance;
+        served = s.served;
+        latency = s.latency;
+        sequence = s.sequence;
+        head = s.head;
+        up = s.up != 0;
+    }
+    //Visit the request being served, then the waiting ones by cylinder (by arrival for fcfs) as visit(h, cylinder)
+    template <class visitor>
+    void for_each(visitor visit) const {
+        if(!empty())
+            visit(serving.h, serving.cylinder);
+        for (std::set<request>::const_iterator i = waiting.begin(); i != waiting.end(); i++)
+            visit(i->h, i->cylinder);
+    }
+};
+
+#endif /* disk_h */
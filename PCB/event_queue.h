@@ -0,0 +1,91 @@
+//
+//  event_queue.h
+//  PCB
+//  CSCI 340 Project
+//
+//  Timestamped events for the discrete event simulation
+//
+
+#ifndef event_queue_h
+#define event_queue_h
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+
+enum event_type : unsigned char {arrival_event, burst_event, device_event};
+
+/*
+ sim_event
+
+ arrival_event  next process of the workload arrives
+ burst_event    CPU burst of process a ends, b is the burst number it was scheduled for
+ device_event   request at the head of device a finishes, b is the device_kind
+ Events at the same time fire in the order they were scheduled
+ */
+struct sim_event {
+    unsigned long long time, sequence;
+    uint32_t a, b;
+    event_type type;
+};
+
+/*
+ event_queue
+
+ Binary min heap of events ordered by time then sequence
+ */
+class event_queue {
+    std::vector<sim_event> heap;
+    unsigned long long sequence = 0;
+
+    //Comparison for std heap functions, true if left fires after right
+    struct later {
+        bool operator()(const sim_event& left, const sim_event& right) const {
+            if(left.time != right.time)
+                return left.time > right.time;
+            return left.sequence > right.sequence;
+        }
+    };
+
+public:
+    void schedule(unsigned long long time, event_type type, uint32_t a = 0, uint32_t b = 0) {
+        sim_event e = {time, sequence++, a, b, type};
+        heap.push_back(e);
+        std::push_heap(heap.begin(), heap.end(), later());
+    }
+    bool empty() const {
+        return heap.empty();
+    }
+    size_t size() const {
+        return heap.size();
+    }
+    const sim_event& next() const {
+        return heap.front();
+    }
+    void pop() {
+        std::pop_heap(heap.begin(), heap.end(), later());
+        heap.pop_back();
+    }
+    void clear() {
+        heap.clear();
+    }
+    //Drop every pending event of type
+    void drop(event_type type) {
+        heap.erase(std::remove_if(heap.begin(), heap.end(), [type](const sim_event& e) { return e.type == type; }), heap.end());
+        std::make_heap(heap.begin(), heap.end(), later());
+    }
+    //Pending events in heap order and the next sequence number, for checkpoints
+    const std::vector<sim_event>& pending() const {
+        return heap;
+    }
+    unsigned long long next_sequence() const {
+        return sequence;
+    }
+    //Replace the queue with events saved from pending, which are already a heap
+    void load(const sim_event* events, size_t count, unsigned long long next_sequence) {
+        heap.assign(events, events + count);
+        sequence = next_sequence;
+    }
+};
+
+#endif /* event_queue_h */
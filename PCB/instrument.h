@@ -0,0 +1,183 @@
+//
+//  instrument.h
+//  PCB
+//  CSCI 340 Project
+//
+//  Latency histograms for the hot paths, compiled in with -DPCB_INSTRUMENT
+//
+
+#ifndef instrument_h
+#define instrument_h
+
+#include <ostream>
+#include <iomanip>
+#include <chrono>
+#include <stdint.h>
+
+//Code paths that are timed
+enum probe_site {probe_create, probe_terminate, probe_printer_request, probe_printer_interrupt,
+    probe_disk_request, probe_disk_interrupt, probe_snapshot,
+    probe_allocate, probe_deallocate, probe_update_cpu,
+    probe_arrival_event, probe_burst_event, probe_device_event, probe_sites};
+
+//Name of probe site in reports
+inline const char* probe_name(probe_site site) {
+    const char* names[] = {"A", "t", "p", "P", "d", "D", "S",
+        "allocate", "deallocate", "updateCPU",
+        "arrival event", "burst event", "device event"};
+    return names[site];
+}
+
+/*
+ latency_histogram
+
+ HDR style histogram of nanoseconds with 16 linear buckets per power of two,
+ so every recorded value is off by at most 1/16 and recording is a few shifts
+ Values below 16 get a bucket each
+ */
+class latency_histogram {
+    static const unsigned int sub_buckets = 16, sub_bits = 4;
+    static const unsigned int buckets = (64 - sub_bits + 1) * sub_buckets;
+    uint64_t counts[buckets];
+    uint64_t total, sum, low, high;
+
+    static unsigned int bucket_of(uint64_t value) {
+        if(value < sub_buckets)
+            return (unsigned int)value;
+        unsigned int msb = 63 - __builtin_clzll(value);
+        return (msb - sub_bits + 1) * sub_buckets + (unsigned int)(value >> (msb - sub_bits)) - sub_buckets;
+    }
+    //Largest value that lands in bucket
+    static uint64_t bucket_high(unsigned int bucket) {
+        if(bucket < sub_buckets)
+            return bucket;
+        unsigned int shift = bucket / sub_buckets - 1;
+        uint64_t sub = bucket % sub_buckets + sub_buckets;
+        return ((sub + 1) << shift) - 1;
+    }
+
+public:
+    latency_histogram() {
+        clear();
+    }
+    void clear() {
+        for (unsigned int i = 0; i < buckets; i++)
+            counts[i] = 0;
+        total = sum = high = 0;
+        low = ~0ull;
+    }
+    void record(uint64_t ns) {
+        counts[bucket_of(ns)]++;
+        total++;
+        sum += ns;
+        if(ns < low)
+            low = ns;
+        if(ns > high)
+            high = ns;
+    }
+    uint64_t count() const {
+        return total;
+    }
+    uint64_t min() const {
+        return total ? low : 0;
+    }
+    uint64_t max() const {
+        return high;
+    }
+    double mean() const {
+        return total ? (double)sum / total : 0.0;
+    }
+    //Value at or below which fraction of the recorded values fall
+    uint64_t percentile(double fraction) const {
+        uint64_t rank = (uint64_t)(fraction * total + 0.5), seen = 0;
+        if(rank == 0)
+            rank = 1;
+        for (unsigned int i = 0; i < buckets; i++) {
+            seen += counts[i];
+            if(seen >= rank)
+                return bucket_high(i) < high ? bucket_high(i) : high;
+        }
+        return high;
+    }
+};
+
+/*
+ probe_table
+
+ One histogram per probe site
+ Every host thread has its own table, so sweep runs do not share counters
+ */
+struct probe_table {
+    latency_histogram sites[probe_sites];
+
+    void clear() {
+        for (int i = 0; i < probe_sites; i++)
+            sites[i].clear();
+    }
+    //Print count, mean and percentiles in nanoseconds of every site that was hit
+    void print(std::ostream& out) const {
+        std::ios::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+        out << "Latency in ns:" << '\n';
+        out << std::setw(15) << std::left << "Probe"
+        << std::setw(12) << std::left << "Count"
+        << std::setw(10) << std::left << "Mean"
+        << std::setw(8) << std::left << "Min"
+        << std::setw(8) << std::left << "p50"
+        << std::setw(8) << std::left << "p90"
+        << std::setw(8) << std::left << "p99"
+        << std::setw(10) << std::left << "p99.9"
+        << "Max" << '\n';
+        for (int i = 0; i < probe_sites; i++) {
+            const latency_histogram& h = sites[i];
+            if(h.count() == 0)
+                continue;
+            out << std::setw(15) << std::left << probe_name((probe_site)i)
+            << std::setw(12) << std::left << h.count()
+            << std::setw(10) << std::left << std::fixed << std::setprecision(1) << h.mean()
+            << std::setw(8) << std::left << h.min()
+            << std::setw(8) << std::left << h.percentile(0.5)
+            << std::setw(8) << std::left << h.percentile(0.9)
+            << std::setw(8) << std::left << h.percentile(0.99)
+            << std::setw(10) << std::left << h.percentile(0.999)
+            << h.max() << '\n';
+        }
+        out.flags(flags);
+        out.precision(precision);
+    }
+};
+
+//Probe table of the calling thread
+inline probe_table& probes() {
+    static thread_local probe_table table;
+    return table;
+}
+
+/*
+ probe_timer
+
+ Records the time from construction to destruction at its site
+ */
+class probe_timer {
+    probe_site site;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    probe_timer(probe_site site) : site(site), start(std::chrono::steady_clock::now()) {}
+    ~probe_timer() {
+        uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        probes().sites[site].record(ns);
+    }
+};
+
+//PCB_PROBE(site) times the rest of the enclosing scope
+//Without PCB_INSTRUMENT it expands to nothing and the hot paths are untouched
+#ifdef PCB_INSTRUMENT
+#define PCB_PROBE_NAME(line) pcb_probe_##line
+#define PCB_PROBE_AT(site, line) probe_timer PCB_PROBE_NAME(line)(site)
+#define PCB_PROBE(site) PCB_PROBE_AT(site, __LINE__)
+#else
+#define PCB_PROBE(site)
+#endif
+
+#endif /* instrument_h */
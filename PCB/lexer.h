@@ -0,0 +1,142 @@
+//
+//  lexer.h
+//  PCB
+//  CSCI 340 Project
+//
+//  Single pass tokenizer and validators for the command grammar
+//  Accepts exactly what the old regular expressions accepted, plus the h snapshot
+//  of the latency histograms:
+//      int         [0-9]*
+//      command     [hpPdD][1-9][0-9]*|[AtS]
+//      snapshot    [rimh]      was [rim]
+//      file name   [a-zA-Z_][a-zA-Z_0-9]*\.[a-zA-Z0-9]+
+//  Nothing here allocates
+//
+
+#ifndef lexer_h
+#define lexer_h
+
+#include <cstddef>
+#include <string>
+
+/*
+ token
+
+ Points into the line it was read from
+ Only valid while that line is
+ */
+struct token {
+    const char* text = nullptr;
+    size_t length = 0;
+
+    std::string str() const {
+        return std::string(text, length);
+    }
+};
+
+namespace lexer {
+    inline bool is_space(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+    }
+    inline bool is_digit(char c) {
+        return c >= '0' && c <= '9';
+    }
+    inline bool is_alpha(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    //Split line into tokens, returns number of tokens found
+    //Returns max_tokens+1 if the line holds more tokens than fit
+    inline size_t tokenize(const char* line, size_t length, token* tokens, size_t max_tokens) {
+        size_t count = 0, i = 0;
+        while (true) {
+            while (i < length && is_space(line[i]))
+                i++;
+            if(i == length)
+                return count;
+            if(count == max_tokens)
+                return max_tokens+1;
+            size_t start = i;
+            while (i < length && !is_space(line[i]))
+                i++;
+            tokens[count].text = line+start;
+            tokens[count].length = i-start;
+            count++;
+        }
+    }
+
+    //[0-9]*
+    inline bool is_int(const char* s, size_t n) {
+        for (size_t i = 0; i < n; i++)
+            if(!is_digit(s[i]))
+                return false;
+        return true;
+    }
+    //[hpPdD][1-9][0-9]*|[AtS]
+    inline bool is_command(const char* s, size_t n) {
+        if(n == 0)
+            return false;
+        switch (s[0]) {
+            case 'A':
+            case 't':
+            case 'S':
+                return n == 1;
+            case 'h':
+            case 'p':
+            case 'P':
+            case 'd':
+            case 'D':
+                return n > 1 && s[1] != '0' && is_int(s+1, n-1);
+            default:
+                return false;
+        }
+    }
+    //[rimh]
+    inline bool is_snapshot(const char* s, size_t n) {
+        return n == 1 && (s[0] == 'r' || s[0] == 'i' || s[0] == 'm' || s[0] == 'h');
+    }
+    //[a-zA-Z_][a-zA-Z_0-9]*\.[a-zA-Z0-9]+
+    inline bool is_file_name(const char* s, size_t n) {
+        if(n == 0 || !(is_alpha(s[0]) || s[0] == '_'))
+            return false;
+        size_t i = 1;
+        while (i < n && (is_alpha(s[i]) || is_digit(s[i]) || s[i] == '_'))
+            i++;
+        if(i == n || s[i] != '.' || ++i == n)
+            return false;
+        for (; i < n; i++)
+            if(!(is_alpha(s[i]) || is_digit(s[i])))
+                return false;
+        return true;
+    }
+
+    //Convert digits to value, fails on empty input or overflow
+    inline bool parse_uint(const char* s, size_t n, unsigned int& value) {
+        if(n == 0)
+            return false;
+        unsigned long long v = 0;
+        for (size_t i = 0; i < n; i++) {
+            if(!is_digit(s[i]))
+                return false;
+            v = v*10 + (s[i]-'0');
+            if(v > 0x7fffffffu)
+                return false;
+        }
+        value = (unsigned int)v;
+        return true;
+    }
+
+    inline bool is_int(const token& t) { return is_int(t.text, t.length); }
+    inline bool is_command(const token& t) { return is_command(t.text, t.length); }
+    inline bool is_snapshot(const token& t) { return is_snapshot(t.text, t.length); }
+    inline bool is_file_name(const token& t) { return is_file_name(t.text, t.length); }
+    inline bool parse_uint(const token& t, unsigned int& value) { return parse_uint(t.text, t.length, value); }
+
+    inline bool is_int(const std::string& s) { return is_int(s.data(), s.size()); }
+    inline bool is_command(const std::string& s) { return is_command(s.data(), s.size()); }
+    inline bool is_snapshot(const std::string& s) { return is_snapshot(s.data(), s.size()); }
+    inline bool is_file_name(const std::string& s) { return is_file_name(s.data(), s.size()); }
+    inline bool parse_uint(const std::string& s, unsigned int& value) { return parse_uint(s.data(), s.size(), value); }
+}
+
+#endif /* lexer_h */
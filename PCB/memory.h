@@ -0,0 +1,727 @@
+//
+//  memory.h
+//  PCB
+//  CSCI 340 Project
+//
+//  Contiguous memory allocator and the free hole index behind it
+//
+
+#ifndef memory_h
+#define memory_h
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <set>
+#include <utility>
+#include <string>
+#include <chrono>
+#include <sys/types.h>
+#include "pid_map.h"
+#include "instrument.h"
+
+/*
+ memory_range
+
+ Contains memory range base and limit, and process pid
+ Comparision operator is overriden to compare starting memory address
+ */
+struct memory_range {
+    unsigned int base, limit;
+    pid_t pid;
+    //Comparision function
+    bool operator<(const memory_range& rhs) const {
+        return this->base < rhs.base; }
+    //Constructors
+    memory_range() : base(0), limit(0), pid(0) { }
+    memory_range(pid_t pid, unsigned int base, unsigned int limit) : base(base), limit(limit), pid(pid) { }
+
+};
+
+/*
+ memory_stats
+
+ Free space, fragmentation and compaction counters of an allocator
+ External fragmentation is the share of free memory outside the largest hole
+ */
+struct memory_stats {
+    unsigned int free = 0, largest_hole = 0, holes = 0;
+    unsigned long long failures = 0, compactions = 0, moved = 0;
+    double compact_seconds = 0;
+
+    double external_fragmentation() const {
+        return free ? 1.0 - (double)largest_hole / free : 0.0;
+    }
+};
+
+/*
+ hole_index
+
+ Free holes of memory kept in a treap ordered by base address
+ Every node also stores the largest hole size in its subtree,
+ so searches for a hole of a given size skip whole subtrees
+ All operations are O(log n) expected
+ Nodes live in one vector and are recycled through a free list
+ Optionally mirrors the holes in a set ordered by size for best fit
+ */
+class hole_index {
+    struct node {
+        unsigned int base, size, max_size, priority;
+        int left, right;
+    };
+    std::vector<node> nodes;
+    std::vector<int> free_nodes;
+    int root = -1;
+    unsigned int count = 0;
+    unsigned int seed = 2463534242u;
+    bool by_size;
+    std::set<std::pair<unsigned int, unsigned int> > sizes;
+
+    //xorshift for treap priorities
+    unsigned int next_priority() {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return seed;
+    }
+    unsigned int max_of(int n) const {
+        return n < 0 ? 0 : nodes[n].max_size;
+    }
+    void update(int n) {
+        nodes[n].max_size = std::max(nodes[n].size, std::max(max_of(nodes[n].left), max_of(nodes[n].right)));
+    }
+    //Split into holes below base and holes at or above base
+    void split(int n, unsigned int base, int& left, int& right) {
+        if(n < 0) {
+            left = right = -1;
+            return;
+        }
+        if(nodes[n].base < base) {
+            split(nodes[n].right, base, nodes[n].right, right);
+            left = n;
+        } else {
+            split(nodes[n].left, base, left, nodes[n].left);
+            right = n;
+        }
+        update(n);
+    }
+    //Join two treaps where every base in left is below every base in right
+    int merge(int left, int right) {
+        if(left < 0)
+            return right;
+        if(right < 0)
+            return left;
+        if(nodes[left].priority > nodes[right].priority) {
+            nodes[left].right = merge(nodes[left].right, right);
+            update(left);
+            return left;
+        }
+        nodes[right].left = merge(left, nodes[right].left);
+        update(right);
+        return right;
+    }
+    //Leftmost hole in subtree with size at least amount
+    int leftmost_fit(int n, unsigned int amount) const {
+        if(max_of(n) < amount)
+            return -1;
+        while (true) {
+            if(max_of(nodes[n].left) >= amount)
+                n = nodes[n].left;
+            else if(nodes[n].size >= amount)
+                return n;
+            else
+                n = nodes[n].right;
+        }
+    }
+    //Change the hole at base in place and fix subtree maximums on the way back up
+    //New base must keep the hole between its neighbours
+    void resize(int n, unsigned int base, unsigned int new_base, unsigned int new_size) {
+        if(nodes[n].base == base) {
+            if(by_size) {
+                sizes.erase(std::make_pair(nodes[n].size, nodes[n].base));
+                sizes.insert(std::make_pair(new_size, new_base));
+            }
+            nodes[n].base = new_base;
+            nodes[n].size = new_size;
+        } else
+            resize(base < nodes[n].base ? nodes[n].left : nodes[n].right, base, new_base, new_size);
+        update(n);
+    }
+
+public:
+    //Hole returned by queries, size is 0 if there is none
+    struct hole {
+        unsigned int base, size;
+    };
+
+    //Constructor
+    hole_index(bool by_size = false) : by_size(by_size) { }
+
+    void clear() {
+        nodes.clear();
+        free_nodes.clear();
+        sizes.clear();
+        root = -1;
+        count = 0;
+    }
+    unsigned int size() const {
+        return count;
+    }
+    unsigned int largest_size() const {
+        return max_of(root);
+    }
+    //Add hole that does not touch any other hole
+    void insert(unsigned int base, unsigned int size) {
+        int n;
+        if(free_nodes.empty()) {
+            n = (int)nodes.size();
+            nodes.push_back(node());
+        } else {
+            n = free_nodes.back();
+            free_nodes.pop_back();
+        }
+        nodes[n].base = base;
+        nodes[n].size = size;
+        nodes[n].max_size = size;
+        nodes[n].priority = next_priority();
+        nodes[n].left = nodes[n].right = -1;
+        int left, right;
+        split(root, base, left, right);
+        root = merge(merge(left, n), right);
+        count++;
+        if(by_size)
+            sizes.insert(std::make_pair(size, base));
+    }
+    //Remove hole starting at base
+    void erase(unsigned int base) {
+        int left, middle, right;
+        split(root, base, left, right);
+        split(right, base+1, middle, right);
+        if(middle >= 0) {
+            if(by_size)
+                sizes.erase(std::make_pair(nodes[middle].size, base));
+            free_nodes.push_back(middle);
+            count--;
+        }
+        root = merge(left, right);
+    }
+    //Hole starting exactly at base
+    hole find(unsigned int base) const {
+        int n = root;
+        while (n >= 0) {
+            if(nodes[n].base == base)
+                return hole{nodes[n].base, nodes[n].size};
+            n = base < nodes[n].base ? nodes[n].left : nodes[n].right;
+        }
+        return hole{0, 0};
+    }
+    //Hole with the highest base below address
+    hole before(unsigned int address) const {
+        hole found = {0, 0};
+        int n = root;
+        while (n >= 0) {
+            if(nodes[n].base < address) {
+                found = hole{nodes[n].base, nodes[n].size};
+                n = nodes[n].right;
+            } else
+                n = nodes[n].left;
+        }
+        return found;
+    }
+    //Largest hole, lowest address on ties
+    hole largest() const {
+        if(root < 0)
+            return hole{0, 0};
+        int n = leftmost_fit(root, max_of(root));
+        return hole{nodes[n].base, nodes[n].size};
+    }
+    //Lowest addressed hole with at least amount
+    hole first_fit(unsigned int amount) const {
+        int n = leftmost_fit(root, amount);
+        return n < 0 ? hole{0, 0} : hole{nodes[n].base, nodes[n].size};
+    }
+    //Lowest addressed hole at or above address with at least amount
+    hole first_fit_from(unsigned int address, unsigned int amount) const {
+        int n = root;
+        //Walk down to the first hole at or above address
+        //On the way, the closest right subtree that may fit is remembered
+        int candidate = -1;
+        while (n >= 0) {
+            if(nodes[n].base < address)
+                n = nodes[n].right;
+            else {
+                if(nodes[n].size >= amount || max_of(nodes[n].right) >= amount)
+                    candidate = n;
+                n = nodes[n].left;
+            }
+        }
+        if(candidate < 0)
+            return hole{0, 0};
+        if(nodes[candidate].size >= amount)
+            return hole{nodes[candidate].base, nodes[candidate].size};
+        n = leftmost_fit(nodes[candidate].right, amount);
+        return hole{nodes[n].base, nodes[n].size};
+    }
+    //Smallest hole with at least amount, lowest address on ties
+    //Only available when constructed with by_size
+    hole best_fit(unsigned int amount) const {
+        std::set<std::pair<unsigned int, unsigned int> >::const_iterator i = sizes.lower_bound(std::make_pair(amount, 0u));
+        return i == sizes.end() ? hole{0, 0} : hole{i->second, i->first};
+    }
+    //Take amount from the front of the hole at base
+    void take(unsigned int base, unsigned int size, unsigned int amount) {
+        if(amount == size)
+            erase(base);
+        else
+            resize(root, base, base+amount, size-amount);
+    }
+    //Return range to the free holes, merging with the holes on either side
+    void release(unsigned int base, unsigned int size) {
+        hole next = find(base+size);
+        if(next.size > 0) {
+            erase(next.base);
+            size += next.size;
+        }
+        hole previous = before(base);
+        if(previous.size > 0 && previous.base+previous.size == base)
+            resize(root, previous.base, previous.base, previous.size+size);
+        else
+            insert(base, size);
+    }
+};
+
+/*
+ Placement policies
+
+ Each policy owns the structure that tracks free space and decides
+ where an allocation goes. memory takes the policy as a template
+ parameter so the search is resolved at compile time
+    take        find space for amount and remove it, false if nothing fits
+    give        return space taken earlier
+    claim       take exactly the block at base, for rebuilding from a checkpoint
+    position    where the next search starts, 0 for policies that always start at the bottom
+    block_size  space actually reserved for a request of amount
+    holes       number of free holes
+    largest     size of the largest free hole
+    compact     allocations were slid below end, free space is now one hole above it,
+                false if the policy cannot compact
+ */
+enum placement_policy {first_fit_placement, best_fit_placement, worst_fit_placement, next_fit_placement, buddy_placement};
+
+//Shared base for the policies that carve requests out of holes
+class hole_placement {
+protected:
+    hole_index holes;
+
+    //Carve amount from the front of hole h
+    bool take_from(hole_index::hole h, unsigned int amount, unsigned int& base) {
+        if(h.size < amount || h.size == 0)
+            return false;
+        holes.take(h.base, h.size, amount);
+        base = h.base;
+        return true;
+    }
+
+public:
+    hole_placement(bool by_size = false) : holes(by_size) { }
+
+    void reset(unsigned int memory_cap) {
+        holes.clear();
+        if(memory_cap > 0)
+            holes.insert(0, memory_cap);
+    }
+    void give(unsigned int base, unsigned int amount) {
+        holes.release(base, amount);
+    }
+    //Split the hole around base so [base, base+amount) is taken
+    bool claim(unsigned int base, unsigned int amount) {
+        hole_index::hole h = holes.before(base+1);
+        if(h.size == 0 || h.base + h.size < base + amount)
+            return false;
+        holes.erase(h.base);
+        if(h.base < base)
+            holes.insert(h.base, base - h.base);
+        if(base + amount < h.base + h.size)
+            holes.insert(base + amount, h.base + h.size - base - amount);
+        return true;
+    }
+    unsigned int position() const {
+        return 0;
+    }
+    void set_position(unsigned int cursor) { }
+    unsigned int block_size(unsigned int amount) const {
+        return amount;
+    }
+    unsigned int hole_count() const {
+        return holes.size();
+    }
+    unsigned int largest() const {
+        return holes.largest_size();
+    }
+    bool compact(unsigned int end, unsigned int memory_cap) {
+        holes.clear();
+        if(end < memory_cap)
+            holes.insert(end, memory_cap-end);
+        return true;
+    }
+};
+
+//Lowest addressed hole that fits
+class first_fit : public hole_placement {
+public:
+    bool take(unsigned int amount, unsigned int& base) {
+        return take_from(holes.first_fit(amount), amount, base);
+    }
+};
+
+//Smallest hole that fits
+class best_fit : public hole_placement {
+public:
+    best_fit() : hole_placement(true) { }
+
+    bool take(unsigned int amount, unsigned int& base) {
+        return take_from(holes.best_fit(amount), amount, base);
+    }
+};
+
+//Largest hole
+class worst_fit : public hole_placement {
+public:
+    bool take(unsigned int amount, unsigned int& base) {
+        return take_from(holes.largest(), amount, base);
+    }
+};
+
+//First hole that fits after the previous allocation, wrapping to the start
+class next_fit : public hole_placement {
+    unsigned int cursor = 0;
+
+public:
+    void reset(unsigned int memory_cap) {
+        hole_placement::reset(memory_cap);
+        cursor = 0;
+    }
+    bool take(unsigned int amount, unsigned int& base) {
+        hole_index::hole h = holes.first_fit_from(cursor, amount);
+        if(h.size == 0)
+            h = holes.first_fit(amount);
+        if(!take_from(h, amount, base))
+            return false;
+        cursor = base+amount;
+        return true;
+    }
+    unsigned int position() const {
+        return cursor;
+    }
+    void set_position(unsigned int cursor) {
+        this->cursor = cursor;
+    }
+    bool compact(unsigned int end, unsigned int memory_cap) {
+        cursor = end;
+        return hole_placement::compact(end, memory_cap);
+    }
+};
+
+/*
+ buddy
+
+ Binary buddy allocator
+ Requests are rounded up to a power of two block
+ Memory that is not a power of two is split into aligned blocks up front,
+ a block is only merged with its buddy if the buddy is free at the same order
+ */
+class buddy {
+    static const unsigned int orders = 32;
+    std::vector<std::set<unsigned int> > free_blocks;
+
+    static unsigned int order_of(unsigned int amount) {
+        unsigned int order = 0;
+        while ((1u << order) < amount)
+            order++;
+        return order;
+    }
+
+public:
+    buddy() : free_blocks(orders) { }
+
+    void reset(unsigned int memory_cap) {
+        for (unsigned int i = 0; i < orders; i++)
+            free_blocks[i].clear();
+        unsigned int address = 0;
+        for (int order = orders-1; order >= 0; order--) {
+            if(memory_cap & (1u << order)) {
+                free_blocks[order].insert(address);
+                address += 1u << order;
+            }
+        }
+    }
+    bool take(unsigned int amount, unsigned int& base) {
+        unsigned int order = order_of(amount);
+        unsigned int available = order;
+        while (available < orders && free_blocks[available].empty())
+            available++;
+        if(available == orders)
+            return false;
+        //Lowest addressed block, split down until it is the right order
+        base = *free_blocks[available].begin();
+        free_blocks[available].erase(free_blocks[available].begin());
+        while (available > order) {
+            available--;
+            free_blocks[available].insert(base + (1u << available));
+        }
+        return true;
+    }
+    void give(unsigned int base, unsigned int amount) {
+        unsigned int order = order_of(amount);
+        while (order+1 < orders) {
+            std::set<unsigned int>::iterator b = free_blocks[order].find(base ^ (1u << order));
+            if(b == free_blocks[order].end())
+                break;
+            free_blocks[order].erase(b);
+            base &= ~(1u << order);
+            order++;
+        }
+        free_blocks[order].insert(base);
+    }
+    unsigned int block_size(unsigned int amount) const {
+        return 1u << order_of(amount);
+    }
+    //Split the free block that holds base down to the block of amount at base
+    bool claim(unsigned int base, unsigned int amount) {
+        unsigned int order = order_of(amount);
+        unsigned int available = order;
+        while (available < orders && !free_blocks[available].count(base & ~((1u << available) - 1)))
+            available++;
+        if(available == orders)
+            return false;
+        unsigned int block = base & ~((1u << available) - 1);
+        free_blocks[available].erase(block);
+        while (available > order) {
+            available--;
+            //Keep the half that holds base, free the other one
+            unsigned int half = base & ~((1u << available) - 1);
+            free_blocks[available].insert(half ^ (1u << available));
+        }
+        return true;
+    }
+    unsigned int position() const {
+        return 0;
+    }
+    void set_position(unsigned int cursor) { }
+    unsigned int hole_count() const {
+        unsigned int count = 0;
+        for (unsigned int i = 0; i < orders; i++)
+            count += (unsigned int)free_blocks[i].size();
+        return count;
+    }
+    unsigned int largest() const {
+        for (int order = orders-1; order >= 0; order--)
+            if(!free_blocks[order].empty())
+                return 1u << order;
+        return 0;
+    }
+    //Blocks have to stay aligned to their size, so they cannot be slid together
+    bool compact(unsigned int end, unsigned int memory_cap) {
+        return false;
+    }
+};
+
+/*
+ memory_manager
+
+ Interface the os uses so the placement policy can be picked at install time
+ */
+class memory_manager {
+public:
+    virtual ~memory_manager() { }
+    //Allocate memory to process, returns start or -1 if it does not fit
+    //A caller that compacts and tries again on failure passes retry, so only the last attempt counts as failed
+    virtual int allocate_memory(pid_t pid, unsigned int amount, bool retry = false) = 0;
+    //Deallocate memory from process
+    virtual bool deallocate_memory(pid_t pid) = 0;
+    //Print out memory allocations and information
+    virtual void memory_snapshot(std::ostream& out) = 0;
+    //Process ran for ticks of CPU and referenced its memory, only paged memory keeps track
+    virtual void reference(pid_t pid, unsigned long long ticks) { }
+    //Free space and fragmentation
+    virtual memory_stats stats() const { return memory_stats(); }
+    //Slide allocations together at the bottom of memory, moved gets the ones that moved
+    //Returns false if the allocator cannot compact
+    virtual bool compact(std::vector<memory_range>& moved) { return false; }
+    //Allocations by address, counters and placement cursor for a checkpoint
+    //Returns false if the allocator cannot be checkpointed
+    virtual bool save(std::vector<memory_range>& allocations, memory_stats& counters, unsigned int& cursor) const { return false; }
+    //Rebuild a new allocator from a checkpoint, returns false if the allocations do not fit
+    virtual bool load(const memory_range* allocations, size_t count, const memory_stats& counters, unsigned int cursor) { return false; }
+};
+
+/*
+ memory
+
+ Contains memory max, free and used space
+ Memory allocations are indexed by pid so deallocation is O(1) expected
+ Free space is tracked by the placement policy
+ */
+template <class placement>
+class memory : public memory_manager {
+private:
+    unsigned int memory_cap, free, used;
+    pid_map<memory_range> memory_allocations;
+    placement policy;
+    memory_stats counters;
+
+public:
+    //Constructor
+    memory(unsigned int memory_cap = 0) {
+        this->memory_cap = memory_cap;
+        this->free = memory_cap;
+        this->used = 0;
+        policy.reset(memory_cap);
+    }
+    //Allocate memory to process
+    int allocate_memory(pid_t pid, unsigned int amount, bool retry = false) {
+        PCB_PROBE(probe_allocate);
+        //Check if there is free space
+        if (amount == 0 || policy.block_size(amount) > free) {
+            if(!retry)
+                counters.failures++;
+            return -1;
+        }
+
+        //If no potential holes are found return -1 indicating cannot allocate
+        unsigned int start;
+        if(!policy.take(amount, start)) {
+            if(!retry)
+                counters.failures++;
+            return -1;
+        }
+
+        memory_allocations.insert(pid, memory_range(pid, start, start+amount-1));
+        free -= policy.block_size(amount);
+        return start;
+    }
+    //Deallocate memory from process
+    bool deallocate_memory(pid_t pid) {
+        PCB_PROBE(probe_deallocate);
+        //Find allocation with corrent pid and add amount back to available
+        memory_range* range = memory_allocations.find(pid);
+        if(!range)
+            return false;
+        free+=policy.block_size(range->limit-range->base+1);
+        policy.give(range->base, range->limit-range->base+1);
+        memory_allocations.erase(pid);
+        return true;
+    }
+    //Print out memory allocations and information
+    //Allocations are sorted by start address only here
+    void memory_snapshot(std::ostream& out) {
+        std::vector<memory_range> ranges;
+        ranges.reserve(memory_allocations.size());
+        memory_allocations.for_each([&ranges](pid_t, const memory_range& range) { ranges.push_back(range); });
+        std::sort(ranges.begin(), ranges.end());
+        out << std::setw(5) << std::left << "pid"
+        << std::setw(6) << std::left << "Start"
+        << std::setw(5) << std::left << "End"
+        << std::setw(5) << std::left << "Usage" << '\n';
+        for (std::vector<memory_range>::iterator i = ranges.begin(); i != ranges.end(); i++) {
+            out << std::setw(5) << std::left << i->pid
+            << std::setw(5) << std::left << i->base
+            << std::setw(5) << std::left << i->limit
+            << std::setw(5) << std::left << i->limit-i->base+1 << '\n';
+        }
+        out << "Used Memory: " << memory_cap-free << '\n';
+        out << "Free Memory: " << free << '\n';
+    }
+    //Visit every allocation as visit(range), in no particular order
+    template <class visitor>
+    void for_each_allocation(visitor visit) const {
+        memory_allocations.for_each([&visit](pid_t, const memory_range& range) { visit(range); });
+    }
+    memory_stats stats() const {
+        memory_stats s = counters;
+        s.free = free;
+        s.largest_hole = policy.largest();
+        s.holes = policy.hole_count();
+        return s;
+    }
+    bool save(std::vector<memory_range>& allocations, memory_stats& saved, unsigned int& cursor) const {
+        allocations.clear();
+        allocations.reserve(memory_allocations.size());
+        memory_allocations.for_each([&allocations](pid_t, const memory_range& range) { allocations.push_back(range); });
+        std::sort(allocations.begin(), allocations.end());
+        saved = counters;
+        cursor = policy.position();
+        return true;
+    }
+    bool load(const memory_range* allocations, size_t count, const memory_stats& saved, unsigned int cursor) {
+        for (size_t i = 0; i < count; i++) {
+            unsigned int size = allocations[i].limit-allocations[i].base+1;
+            if(!policy.claim(allocations[i].base, size))
+                return false;
+            memory_allocations.insert(allocations[i].pid, allocations[i]);
+            free -= policy.block_size(size);
+        }
+        counters = saved;
+        policy.set_position(cursor);
+        return true;
+    }
+    //Sort allocations by address once, then slide each one down to the end of the one before
+    bool compact(std::vector<memory_range>& moved) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<memory_range> ranges;
+        ranges.reserve(memory_allocations.size());
+        memory_allocations.for_each([&ranges](pid_t, const memory_range& range) { ranges.push_back(range); });
+        std::sort(ranges.begin(), ranges.end());
+        unsigned int end = 0;
+        for (size_t i = 0; i < ranges.size(); i++)
+            end += policy.block_size(ranges[i].limit-ranges[i].base+1);
+        if(!policy.compact(end, memory_cap))
+            return false;
+        end = 0;
+        for (size_t i = 0; i < ranges.size(); i++) {
+            unsigned int size = ranges[i].limit-ranges[i].base+1;
+            if(ranges[i].base != end) {
+                memory_range* range = memory_allocations.find(ranges[i].pid);
+                range->base = end;
+                range->limit = end+size-1;
+                moved.push_back(*range);
+                counters.moved += size;
+            }
+            end += size;
+        }
+        counters.compactions++;
+        counters.compact_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return true;
+    }
+};
+
+//Name of policy used at install time
+inline const char* placement_name(placement_policy policy) {
+    const char* names[] = {"first", "best", "worst", "next", "buddy"};
+    return names[policy];
+}
+//Parse policy name used at install time
+inline bool parse_placement(const char* s, size_t n, placement_policy& policy) {
+    for (int i = 0; i < 5; i++) {
+        const char* name = placement_name((placement_policy)i);
+        if(std::char_traits<char>::length(name) == n && std::char_traits<char>::compare(name, s, n) == 0) {
+            policy = (placement_policy)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+//Create allocator for policy
+inline memory_manager* make_memory(placement_policy policy, unsigned int memory_cap) {
+    switch (policy) {
+        case first_fit_placement: return new memory<first_fit>(memory_cap);
+        case best_fit_placement: return new memory<best_fit>(memory_cap);
+        case next_fit_placement: return new memory<next_fit>(memory_cap);
+        case buddy_placement: return new memory<buddy>(memory_cap);
+        default: return new memory<worst_fit>(memory_cap);
+    }
+}
+
+#endif /* memory_h */
@@ -0,0 +1,1990 @@
+//
+//  os.h
+//  PCB
+//  CSCI 340 Project
+//
+//  The simulated os: setup, commands, batch, pipelined and simulated runs, reports and checkpoints
+//
+
+#ifndef os_h
+#define os_h
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <deque>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <cstring>
+#include <thread>
+#include "lexer.h"
+#include "process.h"
+#include "memory.h"
+#include "paging.h"
+#include "pid_map.h"
+#include "scheduler.h"
+#include "device.h"
+#include "disk.h"
+#include "event_queue.h"
+#include "sweep.h"
+#include "stats_export.h"
+#include "checkpoint.h"
+#include "pipeline.h"
+
+/*
+ command
+ 
+ One fully parsed command with its arguments
+ Filled in by the interactive prompts or by a line of a batch trace
+ */
+struct command {
+    char type = 0;
+    unsigned int device = 0;
+    unsigned int memory_amount = 0, priority = 0;
+    std::string file_name;
+    unsigned int file_size = 0;
+    //Disk requests only, the file's own cylinder unless the trace names one
+    unsigned int cylinder = 0;
+    char snapshot = 0;
+};
+
+//Why a trace line did not parse
+enum parse_error {parse_ok, invalid_command, invalid_process, invalid_file_size, invalid_cylinder, invalid_snapshot};
+
+/*
+ command_record
+
+ Fixed size binary form of a parsed command, how the parse stage of a pipelined run
+ hands commands to the simulation thread
+ Names that do not fit inline are moved to the heap and freed by the consumer
+ A line that did not parse keeps its error, and for a bad cylinder the offending token as name,
+ so the message is printed in order with the output of the commands around it
+ */
+struct command_record {
+    static const size_t name_capacity = 88;
+    char type, snapshot;
+    uint8_t error, pad;
+    uint32_t device, memory_amount, priority, file_size, cylinder;
+    uint32_t name_length;
+    std::string* long_name;
+    char name[name_capacity];
+};
+
+/*
+ job_step
+ 
+ One device request of a simulated process, followed by its next CPU burst
+ */
+struct job_step {
+    device_kind kind;
+    unsigned int device;
+    uint32_t file_name;
+    unsigned int file_size, cylinder;
+    unsigned long long burst;
+};
+
+/*
+ sweep_result
+ 
+ Metrics of one simulation run of a sweep
+ */
+struct sweep_result {
+    size_t run;
+    sweep_point point;
+    unsigned long long finished, rejected, events, clock;
+    double average_turnaround, average_waiting, utilization, seconds;
+};
+
+/*
+ cpu_core
+ 
+ One simulated CPU with its own ready queue and counters
+ */
+struct cpu_core {
+    process_handle running_process = no_process;
+    //Ready processes, ordered by the scheduling policy chosen at setup
+    scheduler* ready_queue = nullptr;
+    //Ticks spent running processes, processes given the CPU and processes moved here from another core
+    unsigned long long busy_time = 0, dispatches = 0, migrations = 0;
+};
+
+/*
+ checkpoint_config
+ 
+ Setup, clock and counters of the os in a checkpoint
+ workload_offset is where the rest of a simulated workload starts, -1 once it is all read
+ */
+struct checkpoint_config {
+    uint32_t memory_cap, printers, disks, cores;
+    uint32_t placement, scheduling, paging, page_size, quantum;
+    uint32_t printer_rate, disk_rate, disk_policy, cylinders, seek_rate;
+    uint32_t compact_on_demand, compact_threshold, simulating, idle_cores;
+    uint32_t pending_memory, pending_priority;
+    int64_t pid_counter, workload_offset;
+    uint64_t clock, context_switches, preemptions, event_sequence;
+    uint64_t events_fired, finished, rejected, total_turnaround, total_waiting, pending_burst;
+};
+
+/*
+ checkpoint_core
+ 
+ Counters of one core in a checkpoint, with the number of ready processes and scheduler state words it has
+ */
+struct checkpoint_core {
+    uint32_t running, ready, state, pad;
+    uint64_t busy_time, dispatches, migrations;
+};
+
+//Sections of a checkpoint, arrays are flattened with a count per core, device or process
+enum checkpoint_section : uint32_t {
+    ck_config, ck_pid, ck_priority, ck_memory_base, ck_status, ck_file_size, ck_file_name,
+    ck_io_time, ck_arrival_time, ck_ready_time, ck_dispatch_time, ck_wait_time, ck_burst_left,
+    ck_burst_count, ck_core, ck_free_slots, ck_file_name_text, ck_file_name_length,
+    ck_cores, ck_ready, ck_scheduler_state, ck_printer_count, ck_printer_queue,
+    ck_printer_stats, ck_disk_stats, ck_disks, ck_disk_requests,
+    ck_memory, ck_memory_stats, ck_memory_cursor, ck_events,
+    ck_job_count, ck_job_steps, ck_job_position, ck_pending_steps
+};
+
+/*
+ os
+ 
+ Contains cores with their ready queues and device queues
+ PCBs live in a pool and queues hold their handles
+ Also has max system memory, pid counter, and
+ processes running on the cores
+ Processes stay on their core, except that an idle core steals from the
+ longest ready queue and a process waking up goes to an idle core if its own is busy
+ */
+class os {
+private:
+    unsigned int memory_cap, num_printers, num_disks;
+    placement_policy placement = worst_fit_placement;
+    scheduling_policy scheduling = priority_scheduling;
+    pid_t pid_counter = 0;
+    std::vector<cpu_core> cores;
+    //Cores with nothing running
+    unsigned int idle_cores = 0;
+    process_pool process_table;
+    //Time slice of round robin, mlfq and cfs in ticks
+    unsigned int quantum = 4;
+    //Paged memory replaces the contiguous allocator unless paging is no_paging
+    paging_policy paging = no_paging;
+    unsigned int page_size = 256;
+    //Compact when an allocation fails although enough memory is free,
+    //and after a deallocation leaves external fragmentation at or above the threshold in percent
+    bool compact_on_demand = false;
+    unsigned int compact_threshold = 0;
+    //Live processes by pid, wherever they are queued
+    pid_map<process_handle> processes;
+    //Dispatcher counters
+    unsigned long long context_switches = 0, preemptions = 0;
+    std::vector<std::deque<process_handle>> printer_queue;
+    std::vector<disk> disk_queue;
+    //Order of disk requests, number of cylinders and head speed in cylinders per tick
+    disk_scheduling disk_policy = fcfs_disk;
+    unsigned int cylinders = 200, seek_rate = 0;
+    //Timed devices complete on their own after a service time based on file size
+    //Rate is file size units served per tick, 0 leaves the device to P/D interrupts
+    unsigned int printer_rate = 0, disk_rate = 0;
+    unsigned long long clock = 0;
+    //Device completions, and in simulation mode arrivals and CPU bursts
+    event_queue events;
+    std::vector<device_stats> printer_stats, disk_stats;
+    memory_manager* memory_allocator = nullptr;
+    //Batch mode reads whole command lines and never prompts
+    bool batch = false;
+    //Simulation mode runs processes through their CPU bursts and device requests
+    bool simulating = false;
+    //Remaining device requests of every simulated process by handle
+    std::vector<std::vector<job_step>> jobs;
+    std::vector<unsigned int> job_position;
+    //Next workload line, waiting for its arrival event
+    struct arrival {
+        unsigned int memory_amount = 0, priority = 0;
+        unsigned long long burst = 0;
+        std::vector<job_step> steps;
+    } pending;
+    //Simulation results
+    unsigned long long events_fired = 0, finished = 0, rejected = 0;
+    unsigned long long total_turnaround = 0, total_waiting = 0;
+    //Machine readable snapshots, written on every S command, at the end of a run
+    //and in simulation mode every stats_every ticks of virtual time
+    stats_writer* stats = nullptr;
+    stats_record record;
+    unsigned long long stats_every = 0, next_stats = 0;
+    //Reports and snapshots go to out, per event messages and errors go to log
+    std::ostream* out = &std::cout;
+    std::ostream* log = &std::cout;
+    std::ostream null_log{nullptr};
+    //Checkpoint written when the trace ends, or in a simulation before the first event after save_at
+    const char* save_file = nullptr;
+    unsigned long long save_at = ~0ull;
+    //State came from a checkpoint, so there is no setup line to read
+    bool restored = false;
+    //Where the rest of the simulated workload starts in a restored checkpoint
+    long long workload_offset = -1;
+    //Command records in flight between the parse and simulation stages of a pipelined batch run, 0 runs serially
+    size_t pipeline_depth = 0;
+    static const size_t output_chunks = 64;
+    static const uint32_t checkpoint_version = 2;
+    //Longest trace line is a device call with file name and size
+    //Setup line may also name a placement and a scheduling policy and the number of cores
+    static const size_t max_tokens = 6;
+    static const unsigned int max_cores = 1024;
+    //Workload line is a process and up to eight device requests
+    static const size_t max_workload_tokens = 36;
+    static constexpr const char* setup_usage = "<memory> <printers> <disks> [first|best|worst|next|buddy [priority|rr|mlfq|srtf|cfs [cores]]]";
+    
+    //Print prompt for the next interactive input
+    void prompt(const char* message) {
+        if(!batch)
+            *out << message << '\n';
+    }
+    
+public:
+    //Deconstructor
+    //PCBs are released with the pool
+    ~os(){
+        delete memory_allocator;
+        memory_allocator = nullptr;
+        for (size_t i = 0; i < cores.size(); i++)
+            delete cores[i].ready_queue;
+    }
+    //Setup up OS
+    //Will not continue until recieves proper inputs
+    //Returns false if input ends before setup is complete
+    bool install(std::istream& in) {
+        std::string input;
+        prompt("Entering OS Setup....\n\n");
+        
+        while (true) {
+            prompt("Enter amount of memory: ");
+            if(!(in >> input))
+                return false;
+            if(lexer::parse_uint(input, memory_cap))
+                break;
+            else
+                *log << "Not a valid input\n" << '\n';
+        }
+        while (true) {
+            prompt("Enter number of printers: ");
+            if(!(in >> input))
+                return false;
+            if(lexer::parse_uint(input, num_printers))
+                break;
+            else
+                *log << "Not a valid input\n" << '\n';
+        }
+        while (true) {
+            prompt("Enter number of disks: ");
+            if(!(in >> input))
+                return false;
+            if(lexer::parse_uint(input, num_disks))
+                break;
+            else
+                *log << "Not a valid input\n" << '\n';
+        }
+        placement_policy placement;
+        while (true) {
+            prompt("Enter memory placement policy (first, best, worst, next, buddy): ");
+            if(!(in >> input))
+                return false;
+            if(parse_placement(input.data(), input.size(), placement))
+                break;
+            else
+                *log << "Not a valid input\n" << '\n';
+        }
+        scheduling_policy scheduling;
+        while (true) {
+            prompt("Enter scheduling policy (priority, rr, mlfq, srtf, cfs): ");
+            if(!(in >> input))
+                return false;
+            if(parse_scheduling(input.data(), input.size(), scheduling))
+                break;
+            else
+                *log << "Not a valid input\n" << '\n';
+        }
+        unsigned int num_cores;
+        while (true) {
+            prompt("Enter number of cores: ");
+            if(!(in >> input))
+                return false;
+            if(lexer::parse_uint(input, num_cores) && num_cores > 0 && num_cores <= max_cores)
+                break;
+            else
+                *log << "Not a valid input\n" << '\n';
+        }
+        setup(memory_cap, num_printers, num_disks, placement, scheduling, num_cores);
+        return true;
+    }
+    //Initilize memory, cores and devices
+    void setup(unsigned int memory_cap, unsigned int num_printers, unsigned int num_disks,
+               placement_policy placement, scheduling_policy scheduling, unsigned int num_cores) {
+        this->memory_cap = memory_cap;
+        this->num_printers = num_printers;
+        this->num_disks = num_disks;
+        this->placement = placement;
+        this->scheduling = scheduling;
+        delete memory_allocator;
+        memory_allocator = make_memory(placement, paging, memory_cap, page_size);
+        for (size_t i = 0; i < cores.size(); i++)
+            delete cores[i].ready_queue;
+        cores.assign(num_cores, cpu_core());
+        for (size_t i = 0; i < cores.size(); i++)
+            cores[i].ready_queue = make_scheduler(scheduling, process_table, quantum);
+        idle_cores = num_cores;
+        printer_queue.resize(num_printers);
+        disk_queue.assign(num_disks, disk(disk_policy, cylinders));
+        printer_stats.resize(num_printers);
+        disk_stats.resize(num_disks);
+    }
+    //Make devices complete requests on their own, 0 keeps manual interrupts
+    void set_device_rates(unsigned int printer_rate, unsigned int disk_rate) {
+        this->printer_rate = printer_rate;
+        this->disk_rate = disk_rate;
+    }
+    //Order disk requests by policy, seek_rate 0 makes seeks take no time
+    void set_disk_scheduling(disk_scheduling policy, unsigned int cylinders, unsigned int seek_rate) {
+        disk_policy = policy;
+        this->cylinders = cylinders;
+        this->seek_rate = seek_rate;
+    }
+    //Parse, simulate and write output of a batch run on three threads, depth command records apart
+    void set_pipeline(size_t depth) {
+        pipeline_depth = depth;
+    }
+    //Time slice for round robin, mlfq and cfs
+    void set_quantum(unsigned int quantum) {
+        this->quantum = quantum;
+    }
+    //Use paged memory with page replacement instead of contiguous placement
+    void set_paging(paging_policy paging, unsigned int page_size) {
+        this->paging = paging;
+        this->page_size = page_size;
+    }
+    //Compact memory when it is fragmented, a threshold of 0 only compacts on demand
+    void set_compaction(bool on_demand, unsigned int threshold) {
+        compact_on_demand = on_demand;
+        compact_threshold = threshold;
+    }
+    //Export snapshots to writer, every ticks of a simulation as well, 0 for none in between
+    void set_stats(stats_writer* writer, unsigned long long every) {
+        stats = writer;
+        stats_every = every;
+        next_stats = every;
+    }
+    //Save a checkpoint to file at the end of the trace, or before the first simulated event after time
+    void set_checkpoint(const char* file, unsigned long long time) {
+        save_file = file;
+        save_at = time;
+    }
+    //Write every PCB, queue, device, allocation and pending event to file in one write
+    //offset is where the unread part of a simulated workload starts, -1 if there is none
+    //Returns false if the allocator cannot be checkpointed or the file cannot be written
+    bool save_checkpoint(const char* file, long long offset) {
+        checkpoint_config config;
+        std::memset(&config, 0, sizeof(config));
+        config.memory_cap = memory_cap;
+        config.printers = num_printers;
+        config.disks = num_disks;
+        config.cores = (uint32_t)cores.size();
+        config.placement = placement;
+        config.scheduling = scheduling;
+        config.paging = paging;
+        config.page_size = page_size;
+        config.quantum = quantum;
+        config.printer_rate = printer_rate;
+        config.disk_rate = disk_rate;
+        config.disk_policy = disk_policy;
+        config.cylinders = cylinders;
+        config.seek_rate = seek_rate;
+        config.compact_on_demand = compact_on_demand;
+        config.compact_threshold = compact_threshold;
+        config.simulating = simulating;
+        config.idle_cores = idle_cores;
+        config.pending_memory = pending.memory_amount;
+        config.pending_priority = pending.priority;
+        config.pid_counter = pid_counter;
+        config.workload_offset = offset;
+        config.clock = clock;
+        config.context_switches = context_switches;
+        config.preemptions = preemptions;
+        config.event_sequence = events.next_sequence();
+        config.events_fired = events_fired;
+        config.finished = finished;
+        config.rejected = rejected;
+        config.total_turnaround = total_turnaround;
+        config.total_waiting = total_waiting;
+        config.pending_burst = pending.burst;
+
+        std::vector<memory_range> allocations;
+        memory_stats memory_counters;
+        unsigned int cursor;
+        if(!memory_allocator->save(allocations, memory_counters, cursor)) {
+            *log << "ERROR: Paged memory cannot be checkpointed" << '\n';
+            return false;
+        }
+
+        checkpoint_writer w(checkpoint_version);
+        w.section(ck_config, &config, 1);
+        w.section(ck_pid, process_table.pid);
+        w.section(ck_priority, process_table.priority);
+        w.section(ck_memory_base, process_table.memory_base);
+        w.section(ck_status, process_table.status);
+        w.section(ck_file_size, process_table.file_size);
+        w.section(ck_file_name, process_table.file_name);
+        w.section(ck_io_time, process_table.io_time);
+        w.section(ck_arrival_time, process_table.arrival_time);
+        w.section(ck_ready_time, process_table.ready_time);
+        w.section(ck_dispatch_time, process_table.dispatch_time);
+        w.section(ck_wait_time, process_table.wait_time);
+        w.section(ck_burst_left, process_table.burst_left);
+        w.section(ck_burst_count, process_table.burst_count);
+        w.section(ck_core, process_table.core);
+        w.section(ck_free_slots, process_table.free_list());
+        std::string text;
+        std::vector<uint32_t> lengths;
+        for (uint32_t i = 0; i < process_table.file_names.size(); i++) {
+            text += process_table.file_names[i];
+            lengths.push_back((uint32_t)process_table.file_names[i].size());
+        }
+        w.section(ck_file_name_text, text.data(), text.size());
+        w.section(ck_file_name_length, lengths);
+
+        std::vector<checkpoint_core> saved_cores(cores.size());
+        std::vector<process_handle> ready;
+        std::vector<uint64_t> scheduler_state, core_state;
+        for (size_t i = 0; i < cores.size(); i++) {
+            size_t queued = ready.size();
+            cores[i].ready_queue->for_each_ordered([&ready](process_handle h) { ready.push_back(h); });
+            cores[i].ready_queue->save(core_state);
+            scheduler_state.insert(scheduler_state.end(), core_state.begin(), core_state.end());
+            saved_cores[i].running = cores[i].running_process;
+            saved_cores[i].ready = (uint32_t)(ready.size() - queued);
+            saved_cores[i].state = (uint32_t)core_state.size();
+            saved_cores[i].busy_time = cores[i].busy_time;
+            saved_cores[i].dispatches = cores[i].dispatches;
+            saved_cores[i].migrations = cores[i].migrations;
+        }
+        w.section(ck_cores, saved_cores);
+        w.section(ck_ready, ready);
+        w.section(ck_scheduler_state, scheduler_state);
+
+        std::vector<uint32_t> printer_count;
+        std::vector<process_handle> printer_requests;
+        for (size_t i = 0; i < printer_queue.size(); i++) {
+            printer_count.push_back((uint32_t)printer_queue[i].size());
+            printer_requests.insert(printer_requests.end(), printer_queue[i].begin(), printer_queue[i].end());
+        }
+        w.section(ck_printer_count, printer_count);
+        w.section(ck_printer_queue, printer_requests);
+        w.section(ck_printer_stats, printer_stats);
+        w.section(ck_disk_stats, disk_stats);
+        std::vector<disk::state> disks(disk_queue.size());
+        std::vector<disk::saved_request> disk_requests;
+        for (size_t i = 0; i < disk_queue.size(); i++)
+            disk_queue[i].save(disks[i], disk_requests);
+        w.section(ck_disks, disks);
+        w.section(ck_disk_requests, disk_requests);
+
+        w.section(ck_memory, allocations);
+        w.section(ck_memory_stats, &memory_counters, 1);
+        w.section(ck_memory_cursor, &cursor, 1);
+        w.section(ck_events, events.pending());
+
+        std::vector<uint32_t> job_count;
+        std::vector<job_step> steps;
+        for (size_t i = 0; i < jobs.size(); i++) {
+            job_count.push_back((uint32_t)jobs[i].size());
+            steps.insert(steps.end(), jobs[i].begin(), jobs[i].end());
+        }
+        w.section(ck_job_count, job_count);
+        w.section(ck_job_steps, steps);
+        w.section(ck_job_position, job_position);
+        w.section(ck_pending_steps, pending.steps);
+        if(!w.write(file)) {
+            *log << "ERROR: Cannot write checkpoint " << file << '\n';
+            return false;
+        }
+        *log << "Saved checkpoint " << file << " at time " << clock << '\n';
+        return true;
+    }
+    //Replace the whole state with a checkpoint, including the setup it was taken with
+    //Every section is read and checked against the others, and the pool, allocator and
+    //ready queues are built on the side, before anything of the running os is replaced
+    //Returns false if file is not a checkpoint of this version or does not hold together,
+    //and the os is left as it was
+    bool load_checkpoint(const char* file) {
+        checkpoint_reader r;
+        checkpoint_config config;
+        if(!r.open(file) || r.version() != checkpoint_version || !r.get(ck_config, config)
+           || config.paging != no_paging || config.cores == 0 || config.cores > max_cores
+           || config.placement > buddy_placement || config.scheduling > cfs_scheduling
+           || config.disk_policy > clook_disk || config.idle_cores > config.cores)
+            return false;
+
+        //PCBs, every column as long as the pid column
+        process_pool table;
+        std::vector<process_handle> free_slots;
+        if(!r.get(ck_pid, table.pid) || !r.get(ck_priority, table.priority)
+           || !r.get(ck_memory_base, table.memory_base) || !r.get(ck_status, table.status)
+           || !r.get(ck_file_size, table.file_size) || !r.get(ck_file_name, table.file_name)
+           || !r.get(ck_io_time, table.io_time) || !r.get(ck_arrival_time, table.arrival_time)
+           || !r.get(ck_ready_time, table.ready_time) || !r.get(ck_dispatch_time, table.dispatch_time)
+           || !r.get(ck_wait_time, table.wait_time) || !r.get(ck_burst_left, table.burst_left)
+           || !r.get(ck_burst_count, table.burst_count) || !r.get(ck_core, table.core)
+           || !r.get(ck_free_slots, free_slots))
+            return false;
+        size_t handles = table.pid.size();
+        if(table.priority.size() != handles || table.memory_base.size() != handles || table.status.size() != handles
+           || table.file_size.size() != handles || table.file_name.size() != handles || table.io_time.size() != handles
+           || table.arrival_time.size() != handles || table.ready_time.size() != handles
+           || table.dispatch_time.size() != handles || table.wait_time.size() != handles
+           || table.burst_left.size() != handles || table.burst_count.size() != handles || table.core.size() != handles)
+            return false;
+        const char* text;
+        const uint32_t* lengths;
+        size_t text_size, names, text_used = 0;
+        if(!r.get(ck_file_name_text, text, text_size) || !r.get(ck_file_name_length, lengths, names))
+            return false;
+        for (size_t i = 0; i < names; i++)
+            text_used += lengths[i];
+        if(text_used != text_size)
+            return false;
+        //Free slots are terminated PCBs, each listed once, and only live PCBs hold a name
+        std::vector<bool> listed(handles, false);
+        for (size_t i = 0; i < free_slots.size(); i++) {
+            process_handle h = free_slots[i];
+            if(h >= handles || listed[h] || table.status[h] != terminated)
+                return false;
+            listed[h] = true;
+        }
+        for (process_handle h = 0; h < handles; h++) {
+            if(table.status[h] > io)
+                return false;
+            if(table.status[h] == terminated ? table.file_name[h] != string_pool::none
+               : table.core[h] >= config.cores || (table.file_name[h] != string_pool::none && table.file_name[h] >= names))
+                return false;
+        }
+        //Only live PCBs can be running or queued
+        auto live = [&table, handles](process_handle h) { return h < handles && table.status[h] != terminated; };
+
+        //Cores, with the ready processes and scheduler state words of all of them back to back
+        const checkpoint_core* saved_cores;
+        const process_handle* ready;
+        const uint64_t* scheduler_state;
+        size_t core_count, ready_count, state_count, ready_total = 0, state_total = 0;
+        if(!r.get(ck_cores, saved_cores, core_count) || core_count != config.cores
+           || !r.get(ck_ready, ready, ready_count) || !r.get(ck_scheduler_state, scheduler_state, state_count))
+            return false;
+        for (size_t i = 0; i < core_count; i++) {
+            if(saved_cores[i].running != no_process && !live(saved_cores[i].running))
+                return false;
+            ready_total += saved_cores[i].ready;
+            state_total += saved_cores[i].state;
+        }
+        if(ready_total != ready_count || state_total != state_count)
+            return false;
+        for (size_t i = 0; i < ready_count; i++)
+            if(!live(ready[i]))
+                return false;
+
+        //Device queues, each section as long as the counts before it say
+        const uint32_t* printer_count;
+        const process_handle* printer_requests;
+        const disk::state* disks;
+        const disk::saved_request* disk_requests;
+        std::vector<device_stats> saved_printer_stats, saved_disk_stats;
+        size_t printer_queues, printer_request_count, disk_count, disk_request_count, printer_total = 0, disk_total = 0;
+        if(!r.get(ck_printer_count, printer_count, printer_queues) || printer_queues != config.printers
+           || !r.get(ck_printer_queue, printer_requests, printer_request_count)
+           || !r.get(ck_printer_stats, saved_printer_stats) || saved_printer_stats.size() != config.printers
+           || !r.get(ck_disk_stats, saved_disk_stats) || saved_disk_stats.size() != config.disks
+           || !r.get(ck_disks, disks, disk_count) || disk_count != config.disks
+           || !r.get(ck_disk_requests, disk_requests, disk_request_count))
+            return false;
+        for (size_t i = 0; i < printer_queues; i++)
+            printer_total += printer_count[i];
+        for (size_t i = 0; i < disk_count; i++)
+            disk_total += disks[i].requests;
+        if(printer_total != printer_request_count || disk_total != disk_request_count)
+            return false;
+        for (size_t i = 0; i < printer_request_count; i++)
+            if(!live(printer_requests[i]))
+                return false;
+        for (size_t i = 0; i < disk_request_count; i++)
+            if(!live(disk_requests[i].h))
+                return false;
+
+        //Device requests of simulated processes, and of the next arrival
+        const uint32_t* job_count;
+        const job_step* steps;
+        std::vector<unsigned int> saved_job_position;
+        std::vector<job_step> pending_steps;
+        size_t job_handles, step_count, step_total = 0;
+        if(!r.get(ck_job_count, job_count, job_handles) || !r.get(ck_job_steps, steps, step_count)
+           || !r.get(ck_job_position, saved_job_position) || !r.get(ck_pending_steps, pending_steps)
+           || job_handles > handles || saved_job_position.size() != job_handles)
+            return false;
+        for (size_t i = 0; i < job_handles; i++) {
+            if(saved_job_position[i] > job_count[i])
+                return false;
+            step_total += job_count[i];
+        }
+        if(step_total != step_count)
+            return false;
+        auto step_valid = [&config, names](const job_step& step) {
+            return (step.kind == printer_device ? step.device < config.printers : step.kind == disk_device && step.device < config.disks)
+            && step.file_name < names;
+        };
+        for (size_t i = 0; i < step_count; i++)
+            if(!step_valid(steps[i]))
+                return false;
+        for (size_t i = 0; i < pending_steps.size(); i++)
+            if(!step_valid(pending_steps[i]))
+                return false;
+
+        //Bursts belong to simulated processes and completions to a device that is serving
+        const sim_event* pending_events;
+        size_t event_count;
+        if(!r.get(ck_events, pending_events, event_count))
+            return false;
+        for (size_t i = 0; i < event_count; i++) {
+            const sim_event& e = pending_events[i];
+            bool valid;
+            switch (e.type) {
+                case arrival_event:
+                    valid = true;
+                    break;
+                case burst_event:
+                    valid = e.a < job_handles;
+                    break;
+                case device_event:
+                    valid = e.b == printer_device ? e.a < config.printers && printer_count[e.a] > 0
+                    : e.b == disk_device && e.a < config.disks && disks[e.a].requests > 0;
+                    break;
+                default:
+                    valid = false;
+            }
+            if(!valid)
+                return false;
+        }
+
+        //Allocations must fit the memory they are loaded into
+        const memory_range* allocations;
+        size_t allocation_count;
+        memory_stats memory_counters;
+        unsigned int cursor;
+        if(!r.get(ck_memory, allocations, allocation_count) || !r.get(ck_memory_stats, memory_counters)
+           || !r.get(ck_memory_cursor, cursor))
+            return false;
+        memory_manager* allocator = make_memory((placement_policy)config.placement, config.memory_cap);
+        if(!allocator->load(allocations, allocation_count, memory_counters, cursor)) {
+            delete allocator;
+            return false;
+        }
+        //Ready queues refer to the os's own pool, which gets the loaded PCBs before anything is pushed
+        std::vector<scheduler*> queues;
+        bool loaded = true;
+        for (size_t i = 0; i < core_count && loaded; i++) {
+            queues.push_back(make_scheduler((scheduling_policy)config.scheduling, process_table, config.quantum));
+            loaded = queues.back()->load(scheduler_state, saved_cores[i].state, handles);
+            scheduler_state += saved_cores[i].state;
+        }
+        if(!loaded) {
+            delete allocator;
+            for (size_t i = 0; i < queues.size(); i++)
+                delete queues[i];
+            return false;
+        }
+
+        //Everything holds together, nothing below can fail
+        set_device_rates(config.printer_rate, config.disk_rate);
+        set_disk_scheduling((disk_scheduling)config.disk_policy, config.cylinders, config.seek_rate);
+        set_quantum(config.quantum);
+        set_paging(no_paging, config.page_size);
+        set_compaction(config.compact_on_demand != 0, config.compact_threshold);
+        memory_cap = config.memory_cap;
+        num_printers = config.printers;
+        num_disks = config.disks;
+        placement = (placement_policy)config.placement;
+        scheduling = (scheduling_policy)config.scheduling;
+        delete memory_allocator;
+        memory_allocator = allocator;
+
+        table.set_free_list(free_slots);
+        table.file_names.restore(text, lengths, names);
+        std::swap(process_table, table);
+        processes.clear();
+        for (process_handle h = 0; h < process_table.capacity(); h++)
+            if(process_table.status[h] != terminated)
+                processes.insert(process_table.pid[h], h);
+
+        for (size_t i = 0; i < cores.size(); i++)
+            delete cores[i].ready_queue;
+        cores.assign(core_count, cpu_core());
+        for (size_t i = 0; i < cores.size(); i++) {
+            cores[i].ready_queue = queues[i];
+            cores[i].running_process = saved_cores[i].running;
+            cores[i].busy_time = saved_cores[i].busy_time;
+            cores[i].dispatches = saved_cores[i].dispatches;
+            cores[i].migrations = saved_cores[i].migrations;
+            for (uint32_t j = 0; j < saved_cores[i].ready; j++)
+                cores[i].ready_queue->push(*ready++);
+        }
+        idle_cores = config.idle_cores;
+
+        printer_queue.assign(printer_queues, std::deque<process_handle>());
+        for (size_t i = 0; i < printer_queue.size(); i++) {
+            printer_queue[i].assign(printer_requests, printer_requests + printer_count[i]);
+            printer_requests += printer_count[i];
+        }
+        disk_queue.assign(disk_count, disk(disk_policy, cylinders));
+        for (size_t i = 0; i < disk_queue.size(); i++) {
+            disk_queue[i].load(disks[i], disk_requests);
+            disk_requests += disks[i].requests;
+        }
+        printer_stats.swap(saved_printer_stats);
+        disk_stats.swap(saved_disk_stats);
+        events.load(pending_events, event_count, config.event_sequence);
+
+        jobs.assign(job_handles, std::vector<job_step>());
+        for (size_t i = 0; i < job_handles; i++) {
+            jobs[i].assign(steps, steps + job_count[i]);
+            steps += job_count[i];
+        }
+        job_position.swap(saved_job_position);
+        pending.steps.swap(pending_steps);
+        pending.memory_amount = config.pending_memory;
+        pending.priority = config.pending_priority;
+        pending.burst = config.pending_burst;
+        //Names are referenced by live PCBs and by steps not yet sent to a device
+        string_pool& names_in_use = process_table.file_names;
+        for (process_handle h = 0; h < process_table.capacity(); h++) {
+            if(process_table.status[h] == terminated)
+                continue;
+            if(process_table.file_name[h] != string_pool::none)
+                names_in_use.retain(process_table.file_name[h]);
+            for (size_t i = h < jobs.size() ? job_position[h] : 0; h < jobs.size() && i < jobs[h].size(); i++)
+                names_in_use.retain(jobs[h][i].file_name);
+        }
+        for (size_t i = 0; i < pending.steps.size(); i++)
+            names_in_use.retain(pending.steps[i].file_name);
+        names_in_use.prune();
+
+        pid_counter = (pid_t)config.pid_counter;
+        workload_offset = config.workload_offset;
+        clock = config.clock;
+        context_switches = config.context_switches;
+        preemptions = config.preemptions;
+        events_fired = config.events_fired;
+        finished = config.finished;
+        rejected = config.rejected;
+        total_turnaround = config.total_turnaround;
+        total_waiting = config.total_waiting;
+        simulating = config.simulating != 0;
+        if(stats_every)
+            next_stats = (clock / stats_every + 1) * stats_every;
+        restored = true;
+        *log << "Restored checkpoint " << file << " at time " << clock << '\n';
+        return true;
+    }
+    //Drop per event messages, reports are still printed
+    void set_quiet() {
+        log = &null_log;
+    }
+    
+    //Run interactively, prompting for every argument
+    void run() {
+        //Install enviorment, unless it came from a checkpoint
+        if(!restored && !install(std::cin))
+            return;
+        if(simulating)
+            end_simulation();
+        
+        //Display available commands
+        displayCommands();
+        
+        std::string input;
+        while(std::cin >> input) {
+            //Get input and check
+            command c;
+            if(!lexer::is_command(input) || (input.size() > 1 && !lexer::parse_uint(input.data()+1, input.size()-1, c.device))) {
+                *log << "Not a valid command\n" << '\n';
+                continue;
+            }
+            c.type = input[0];
+            switch (c.type) {
+                case 'A': {
+                    std::string memory_amount, priority;
+                    prompt("Enter amount of memory to allocate for process: ");
+                    std::cin >> memory_amount;
+                    if(!lexer::parse_uint(memory_amount, c.memory_amount)) {
+                        *log << "ERROR: Not a valid input. Cancelling....\n" << '\n';
+                        continue;
+                    }
+                    prompt("Enter priority level for process: ");
+                    std::cin >> priority;
+                    if(!lexer::parse_uint(priority, c.priority)) {
+                        *log << "ERROR: Not a valid input. Cancelling....\n" << '\n';
+                        continue;
+                    }
+                    break;
+                }
+                case 'p':
+                case 'd': {
+                    //Only ask for the file once the request can be queued
+                    if(!device_request_valid(c))
+                        continue;
+                    prompt("Enter file name: ");
+                    std::cin >> c.file_name;
+                    std::string file_size;
+                    while (true) {
+                        prompt("Enter file size: ");
+                        if(!(std::cin >> file_size))
+                            return;
+                        if(lexer::parse_uint(file_size, c.file_size))
+                            break;
+                        else
+                            *log << "Not a valid file size\n" << '\n';
+                    }
+                    c.cylinder = file_cylinder(c.file_name.data(), c.file_name.size(), cylinders);
+                    break;
+                }
+                case 'S': {
+                    std::string snapshot_input;
+                    std::cin >> snapshot_input;
+                    if(!lexer::is_snapshot(snapshot_input)) {
+                        *log << "Not a valid snapshot command\n" << '\n';
+                        continue;
+                    }
+                    c.snapshot = snapshot_input[0];
+                    break;
+                }
+            }
+            execute(c);
+        }
+#ifdef PCB_INSTRUMENT
+        latency_report();
+#endif
+    }
+    
+    //Install enviorment from the setup line of a trace or workload
+    //Returns false if it is not valid
+    bool setup(const token* tokens, size_t count) {
+        unsigned int memory_cap, num_printers, num_disks;
+        placement_policy placement = worst_fit_placement;
+        scheduling_policy scheduling = priority_scheduling;
+        unsigned int num_cores = 1;
+        if(count < 3 || count > 6 || !lexer::parse_uint(tokens[0], memory_cap)
+           || !lexer::parse_uint(tokens[1], num_printers) || !lexer::parse_uint(tokens[2], num_disks)
+           || (count >= 4 && !parse_placement(tokens[3].text, tokens[3].length, placement))
+           || (count >= 5 && !parse_scheduling(tokens[4].text, tokens[4].length, scheduling))
+           || (count == 6 && (!lexer::parse_uint(tokens[5], num_cores) || num_cores == 0 || num_cores > max_cores)))
+            return false;
+        setup(memory_cap, num_printers, num_disks, placement, scheduling, num_cores);
+        return true;
+    }
+    
+    //Run non-interactively from a trace
+    //First line holds memory, printers, disks and optionally the placement policy (worst fit if left out)
+    //the scheduling policy (priority if left out) and the number of cores (1 if left out)
+    //Every following line is one complete command, e.g. "A 512 3", "p2 report.txt 4096", "S r"
+    //Blank lines and lines starting with # are skipped
+    void run_batch(std::istream& in) {
+        batch = true;
+        std::string line;
+        token tokens[max_tokens];
+        size_t count = 0;
+        
+        //Install enviorment from the first line, a restored trace has none
+        while (!restored && std::getline(in, line)) {
+            count = lexer::tokenize(line.data(), line.size(), tokens, max_tokens);
+            if(count > 0 && tokens[0].text[0] != '#')
+                break;
+        }
+        if(!restored && !setup(tokens, count)) {
+            *log << "ERROR: Trace must start with " << setup_usage << '\n';
+            return;
+        }
+        if(simulating)
+            end_simulation();
+        
+        if(pipeline_depth)
+            run_pipeline(in);
+        command c;
+        while (!pipeline_depth && std::getline(in, line)) {
+            count = lexer::tokenize(line.data(), line.size(), tokens, max_tokens);
+            if(count == 0 || tokens[0].text[0] == '#')
+                continue;
+            if(parse(tokens, count, c))
+                execute(c);
+        }
+        //Timed devices have not drained yet, so a restored run picks up where the trace ended
+        if(save_file)
+            save_checkpoint(save_file, -1);
+        //Let timed devices finish what is queued
+        if(printer_rate || disk_rate) {
+            run_events(~0ull);
+            device_report();
+        }
+        export_stats(clock);
+#ifdef PCB_INSTRUMENT
+        latency_report();
+#endif
+        out->flush();
+    }
+
+    //Pack command, or the error of a line that did not parse, into r
+    static void pack(const command& c, parse_error error, command_record& r) {
+        r.type = c.type;
+        r.snapshot = c.snapshot;
+        r.error = (uint8_t)error;
+        r.device = c.device;
+        r.memory_amount = c.memory_amount;
+        r.priority = c.priority;
+        r.file_size = c.file_size;
+        r.cylinder = c.cylinder;
+        r.name_length = (uint32_t)c.file_name.size();
+        r.long_name = nullptr;
+        if(c.file_name.size() <= command_record::name_capacity)
+            c.file_name.copy(r.name, c.file_name.size());
+        else
+            r.long_name = new std::string(c.file_name);
+    }
+    //Unpack r into c, reusing the capacity of its file name
+    static void unpack(command_record& r, command& c) {
+        c.type = r.type;
+        c.snapshot = r.snapshot;
+        c.device = r.device;
+        c.memory_amount = r.memory_amount;
+        c.priority = r.priority;
+        c.file_size = r.file_size;
+        c.cylinder = r.cylinder;
+        if(r.long_name) {
+            c.file_name.swap(*r.long_name);
+            delete r.long_name;
+            r.long_name = nullptr;
+        }
+        else
+            c.file_name.assign(r.name, r.name_length);
+    }
+    /*
+     Rest of a batch trace as three stages on their own threads
+     parse     reads and tokenizes lines and decodes them into command records
+     simulate  this thread, executes the records in order
+     output    writes the formatted reports, snapshots and messages
+     Stages are joined by spsc rings, a full ring holds up the stage before it
+     and an empty one the stage after it, and both show up as stalls in the report
+     */
+    void run_pipeline(std::istream& in) {
+        spsc_ring<command_record> commands(pipeline_depth);
+        spsc_ring<output_chunk> chunks(output_chunks);
+        stage_counters stages[] = {stage_counters("parse", "lines"), stage_counters("simulate", "commands"), stage_counters("output", "bytes")};
+        
+        std::thread parser([&]() {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            std::string line;
+            token tokens[max_tokens];
+            command c;
+            while (std::getline(in, line)) {
+                stages[0].items++;
+                size_t count = lexer::tokenize(line.data(), line.size(), tokens, max_tokens);
+                if(count == 0 || tokens[0].text[0] == '#')
+                    continue;
+                parse_error error = decode(tokens, count, c);
+                pack(c, error, *commands.claim());
+                commands.publish();
+            }
+            commands.close();
+            stages[0].seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        });
+        std::ostream& terminal = *out;
+        std::thread writer([&]() {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            while (output_chunk* chunk = chunks.front()) {
+                terminal.write(chunk->data, chunk->length);
+                stages[2].items += chunk->length;
+                chunks.pop();
+            }
+            terminal.flush();
+            stages[2].seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        });
+        
+        //Everything that would have gone to the terminal now goes through the output stage
+        output_pipe pipe_buffer(chunks);
+        std::ostream pipe(&pipe_buffer);
+        std::ostream* saved_out = out;
+        std::ostream* saved_log = log;
+        if(log == out)
+            log = &pipe;
+        out = &pipe;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        command c;
+        while (command_record* r = commands.front()) {
+            parse_error error = (parse_error)r->error;
+            unpack(*r, c);
+            commands.pop();
+            if(error == parse_ok)
+                execute(c);
+            else
+                parse_failed(error, c);
+            stages[1].items++;
+        }
+        stages[1].seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        pipe.flush();
+        pipe_buffer.close();
+        out = saved_out;
+        log = saved_log;
+        parser.join();
+        writer.join();
+        
+        stages[0].add_waits(commands.full_waits());
+        stages[1].add_waits(commands.empty_waits());
+        stages[1].add_waits(chunks.full_waits());
+        stages[2].add_waits(chunks.empty_waits());
+        pipeline_report(*out, stages, 3);
+    }
+
+    //Run a discrete event simulation of a workload
+    //First line is the same setup line as a batch trace
+    //Every following line is one process, arriving at its time in ticks:
+    //"<time> <memory> <priority> <burst> [<p|d><device> <file name> <file size> <burst>]..."
+    //The process runs its first CPU burst, then every device request is followed by another burst,
+    //it terminates when its last burst is done. Devices are always timed, at rate 1 if none is set
+    void run_simulation(std::istream& in) {
+        batch = true;
+        std::string line;
+        token tokens[max_tokens];
+        size_t count = 0;
+
+        while (!restored && std::getline(in, line)) {
+            count = lexer::tokenize(line.data(), line.size(), tokens, max_tokens);
+            if(count > 0 && tokens[0].text[0] != '#')
+                break;
+        }
+        if(!restored && !setup(tokens, count)) {
+            *log << "ERROR: Workload must start with " << setup_usage << '\n';
+            return;
+        }
+        //A restored simulation reads on from where the checkpoint left the workload
+        if(restored && workload_offset >= 0)
+            in.seekg(workload_offset);
+        else if(restored)
+            in.setstate(std::ios::eofbit);
+        double seconds = simulate(in);
+        simulation_report(seconds);
+        export_stats(clock);
+#ifdef PCB_INSTRUMENT
+        latency_report();
+#endif
+        out->flush();
+    }
+    //Run the process lines of a workload on an os that is already set up
+    //Returns wall clock seconds taken
+    double simulate(std::istream& in) {
+        batch = true;
+        simulating = true;
+        set_device_rates(printer_rate ? printer_rate : 1, disk_rate ? disk_rate : 1);
+        std::string line;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        //A restored simulation already holds its next arrival
+        if(!restored)
+            next_arrival(in, line);
+        while (!events.empty()) {
+            sim_event e = events.next();
+            if(save_file && e.time > save_at) {
+                save_checkpoint(save_file, workload_position(in));
+                save_file = nullptr;
+            }
+            events.pop();
+            //Nothing changes between events, so the state before e is the state at the sample time
+            //A gap of several periods gets one sample
+            if(stats_every && e.time >= next_stats) {
+                export_stats(next_stats);
+                next_stats = (e.time / stats_every + 1) * stats_every;
+            }
+            fire(e);
+            if(e.type == arrival_event)
+                next_arrival(in, line);
+        }
+        if(save_file)
+            save_checkpoint(save_file, workload_position(in));
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    //Metrics of a finished simulation
+    sweep_result result(size_t run, const sweep_point& point, double seconds) const {
+        sweep_result r;
+        r.run = run;
+        r.point = point;
+        r.finished = finished;
+        r.rejected = rejected;
+        r.events = events_fired;
+        r.clock = clock;
+        r.average_turnaround = finished ? (double)total_turnaround / finished : 0.0;
+        r.average_waiting = finished ? (double)total_waiting / finished : 0.0;
+        unsigned long long busy = 0;
+        for (size_t i = 0; i < cores.size(); i++)
+            busy += cores[i].busy_time;
+        r.utilization = clock ? (double)busy / clock / cores.size() : 0.0;
+        r.seconds = seconds;
+        return r;
+    }
+    //Offset of the unread part of the workload, -1 once it is all read or if it cannot be told
+    long long workload_position(std::istream& in) {
+        if(in.eof())
+            return -1;
+        std::streamoff offset = in.tellg();
+        if(offset < 0)
+            *log << "ERROR: Workload is not seekable, the checkpoint ends the workload" << '\n';
+        return offset;
+    }
+    //Read workload lines until one is valid and schedule its arrival
+    //Arrivals never go back in time, returns false at end of workload
+    bool next_arrival(std::istream& in, std::string& line) {
+        token tokens[max_workload_tokens];
+        while (std::getline(in, line)) {
+            size_t count = lexer::tokenize(line.data(), line.size(), tokens, max_workload_tokens);
+            if(count == 0 || tokens[0].text[0] == '#')
+                continue;
+            unsigned int time;
+            bool unserved;
+            if(!parse_workload(tokens, count, time, unserved)) {
+                //A process needing a device the setup lacks can never finish, so it counts as rejected
+                if(unserved) {
+                    *log << "ERROR: Process needs a device this setup does not have" << '\n';
+                    rejected++;
+                }
+                else
+                    *log << "ERROR: Not a valid workload line" << '\n';
+                continue;
+            }
+            events.schedule(std::max<unsigned long long>(time, clock), arrival_event);
+            return true;
+        }
+        return false;
+    }
+    //Release the file names of steps from first on, which no process has sent to a device yet
+    void drop_steps(std::vector<job_step>& steps, size_t first) {
+        for (size_t i = first; i < steps.size(); i++)
+            process_table.file_names.release(steps[i].file_name);
+        steps.clear();
+    }
+    //Carry on from a restored simulation with commands instead of the workload
+    //Processes keep their memory, queues and devices, but the rest of the workload,
+    //their remaining device requests and their CPU bursts are dropped
+    void end_simulation() {
+        simulating = false;
+        events.drop(arrival_event);
+        events.drop(burst_event);
+        drop_steps(pending.steps, 0);
+        for (process_handle h = 0; h < jobs.size(); h++)
+            if(process_table.status[h] != terminated)
+                drop_steps(jobs[h], job_position[h]);
+        jobs.assign(process_table.capacity(), std::vector<job_step>());
+        job_position.assign(process_table.capacity(), 0);
+        workload_offset = -1;
+    }
+    //Parse tokens of one workload line into pending
+    //Every step holds a reference to its file name until it is sent to a device
+    //unserved is set when the line is fine but names a printer or disk this setup does not have
+    bool parse_workload(const token* tokens, size_t count, unsigned int& time, bool& unserved) {
+        unserved = false;
+        if(count < 4 || count > max_workload_tokens || (count-4) % 4 != 0)
+            return false;
+        unsigned int burst;
+        if(!lexer::parse_uint(tokens[0], time) || !lexer::parse_uint(tokens[1], pending.memory_amount)
+           || !lexer::parse_uint(tokens[2], pending.priority) || !lexer::parse_uint(tokens[3], burst))
+            return false;
+        pending.burst = burst;
+        drop_steps(pending.steps, 0);
+        for (size_t i = 4; i < count; i += 4) {
+            const token& call = tokens[i];
+            job_step step;
+            if(call.text[0] != 'p' && call.text[0] != 'd') {
+                drop_steps(pending.steps, 0);
+                unserved = false;
+                return false;
+            }
+            step.kind = call.text[0] == 'p' ? printer_device : disk_device;
+            size_t devices = step.kind == printer_device ? printer_queue.size() : disk_queue.size();
+            if(call.length < 2 || !lexer::parse_uint(call.text+1, call.length-1, step.device) || step.device == 0
+               || !lexer::parse_uint(tokens[i+2], step.file_size) || !lexer::parse_uint(tokens[i+3], burst)) {
+                drop_steps(pending.steps, 0);
+                unserved = false;
+                return false;
+            }
+            //Rest of the line is still checked, a malformed line is invalid either way
+            if(step.device > devices)
+                unserved = true;
+            step.device--;
+            step.burst = burst;
+            step.file_name = process_table.file_names.intern(tokens[i+1].text, tokens[i+1].length);
+            step.cylinder = file_cylinder(tokens[i+1].text, tokens[i+1].length, cylinders);
+            pending.steps.push_back(step);
+        }
+        if(unserved) {
+            drop_steps(pending.steps, 0);
+            return false;
+        }
+        return true;
+    }
+    //Handle one event at its time
+    void fire(const sim_event& e) {
+        clock = e.time;
+        events_fired++;
+        switch (e.type) {
+            case arrival_event: {
+                PCB_PROBE(probe_arrival_event);
+                process_handle h = create_process(pending.memory_amount, pending.priority, pending.burst);
+                if(h == no_process) {
+                    rejected++;
+                    drop_steps(pending.steps, 0);
+                    break;
+                }
+                if(h >= jobs.size()) {
+                    jobs.resize(h+1);
+                    job_position.resize(h+1);
+                }
+                //Steps of the slot's last process were all sent, so none of them hold a name
+                jobs[h].swap(pending.steps);
+                pending.steps.clear();
+                job_position[h] = 0;
+                break;
+            }
+            case burst_event: {
+                PCB_PROBE(probe_burst_event);
+                process_handle h = e.a;
+                unsigned int cpu = process_table.core[h];
+                cpu_core& core = cores[cpu];
+                //Burst was cut short by a preemption and rescheduled
+                if(h != core.running_process || process_table.burst_count[h] != e.b)
+                    break;
+                charge_running(cpu);
+                //Time slice ran out before the burst did
+                if(process_table.burst_left[h] > 0) {
+                    core.ready_queue->expire(h);
+                    if(core.ready_queue->empty()) {
+                        schedule_burst(h);
+                        break;
+                    }
+                    process_table.status[h] = waiting;
+                    process_table.ready_time[h] = clock;
+                    core.running_process = core.ready_queue->replace_top(h);
+                    preemptions++;
+                    dispatch(cpu);
+                    break;
+                }
+                //A process created by a command has no job script and is done after its burst
+                if(h >= jobs.size() || job_position[h] == jobs[h].size()) {
+                    terminate_running(cpu);
+                    break;
+                }
+                const job_step& step = jobs[h][job_position[h]++];
+                process_table.burst_left[h] = step.burst;
+                request_device(cpu, step.kind, step.device, step.file_name, step.file_size, step.cylinder);
+                break;
+            }
+            case device_event: {
+                PCB_PROBE(probe_device_event);
+                device_kind kind = (device_kind)e.b;
+                unsigned int opt = e.a;
+                process_handle h = device_front(kind, opt);
+                device_stats& stats = kind == printer_device ? printer_stats[opt] : disk_stats[opt];
+                stats.busy_time += clock - stats.service_start;
+                stats.wait_time += stats.service_start - process_table.io_time[h];
+                stats.response_time += clock - process_table.io_time[h];
+                stats.completed++;
+                complete_device(kind, opt);
+                if(device_front(kind, opt) != no_process)
+                    start_device(kind, opt);
+                break;
+            }
+        }
+    }
+    //Print turnaround, waiting and event throughput of a simulation
+    void simulation_report(double seconds) {
+        std::ios::fmtflags flags = out->flags();
+        *out << "Simulation finished at time " << clock << '\n';
+        *out << "Events: " << events_fired << " in " << std::fixed << std::setprecision(3) << seconds << "s ("
+        << std::setprecision(0) << (seconds > 0 ? events_fired / seconds : 0.0) << " events/sec)" << '\n';
+        *out << "Processes finished: " << finished << " Rejected: " << rejected << '\n';
+        *out << "Average turnaround: " << std::setprecision(2) << (finished ? (double)total_turnaround / finished : 0.0)
+        << " Average waiting: " << (finished ? (double)total_waiting / finished : 0.0) << '\n';
+        out->flags(flags);
+        out->precision(6);
+        core_report();
+        device_report();
+        if(!disk_queue.empty())
+            disk_report();
+        if(paging != no_paging)
+            memory_allocator->memory_snapshot(*out);
+        else
+            memory_report();
+    }
+    //Print utilization and migrations of every core
+    void core_report() {
+        std::ios::fmtflags flags = out->flags();
+        std::streamsize precision = out->precision();
+        *out << std::setw(6) << std::left << "Core"
+        << std::setw(8) << std::left << "Util"
+        << std::setw(12) << std::left << "Dispatches"
+        << "Migrations" << '\n';
+        for (size_t i = 0; i < cores.size(); i++) {
+            *out << std::setw(6) << std::left << i+1
+            << std::setw(8) << std::left << std::fixed << std::setprecision(3) << (clock ? (double)cores[i].busy_time / clock : 0.0)
+            << std::setw(12) << std::left << cores[i].dispatches
+            << cores[i].migrations << '\n';
+        }
+        out->flags(flags);
+        out->precision(precision);
+    }
+
+    //Parse tokens of one trace line into command without printing anything
+    //Only reads settings fixed at setup, so the parse stage of a pipelined run can call it
+    //A bad cylinder leaves its token in the file name for the message
+    parse_error decode(const token* tokens, size_t count, command& c) const {
+        const token& input = tokens[0];
+        c.device = 0;
+        if(!lexer::is_command(input) || (input.length > 1 && !lexer::parse_uint(input.text+1, input.length-1, c.device)))
+            return invalid_command;
+        c.type = input.text[0];
+        switch (c.type) {
+            case 'A':
+                if(count != 3 || !lexer::parse_uint(tokens[1], c.memory_amount) || !lexer::parse_uint(tokens[2], c.priority))
+                    return invalid_process;
+                return parse_ok;
+            case 'p':
+            case 'd':
+                if(count < 3 || count > (c.type == 'd' ? 4 : 3) || !lexer::parse_uint(tokens[2], c.file_size))
+                    return invalid_file_size;
+                c.file_name.assign(tokens[1].text, tokens[1].length);
+                if(c.type == 'p')
+                    return parse_ok;
+                //Disk request may name its cylinder
+                c.cylinder = file_cylinder(tokens[1].text, tokens[1].length, cylinders);
+                if(count == 4 && (!lexer::parse_uint(tokens[3], c.cylinder) || c.cylinder >= cylinders)) {
+                    c.file_name.assign(tokens[3].text, tokens[3].length);
+                    return invalid_cylinder;
+                }
+                return parse_ok;
+            case 'S':
+                if(count != 2 || !lexer::is_snapshot(tokens[1]))
+                    return invalid_snapshot;
+                c.snapshot = tokens[1].text[0];
+                return parse_ok;
+            default:
+                if(count != 1)
+                    return invalid_command;
+                return parse_ok;
+        }
+    }
+    //Print why a line did not parse
+    void parse_failed(parse_error error, const command& c) {
+        switch (error) {
+            case invalid_process:
+                *log << "ERROR: Not a valid input. Cancelling....\n" << '\n';
+                break;
+            case invalid_file_size:
+                *log << "Not a valid file size\n" << '\n';
+                break;
+            case invalid_cylinder:
+                *log << "Requested Cylinder: " << c.file_name << " Cylinders: " << cylinders << '\n';
+                *log << "ERROR: Not valid cylinder" << '\n';
+                break;
+            case invalid_snapshot:
+                *log << "Not a valid snapshot command\n" << '\n';
+                break;
+            default:
+                *log << "Not a valid command\n" << '\n';
+                break;
+        }
+    }
+    //Parse tokens of one trace line into command
+    //Prints error and returns false on invalid line
+    bool parse(const token* tokens, size_t count, command& c) {
+        parse_error error = decode(tokens, count, c);
+        if(error != parse_ok)
+            parse_failed(error, c);
+        return error == parse_ok;
+    }
+    
+    //Check that a p or d system call can be queued
+    bool device_request_valid(const command& c) {
+        if(command_core() == cores.size()) {
+            *log << "ERROR: No running process" << '\n';
+            return false;
+        }
+        size_t devices = c.type == 'p' ? printer_queue.size() : disk_queue.size();
+        if(c.device > devices) {
+            if(c.type == 'p') {
+                *log << "Requested Printer: " << c.device << " Available Printers: " << devices << '\n';
+                *log << "ERROR: Not valid printer" << '\n';
+            } else {
+                *log << "Requested Disk: " << c.device << " Available Disks: " << devices << '\n';
+                *log << "ERROR: Not valid disk" << '\n';
+            }
+            return false;
+        }
+        return true;
+    }
+    
+    //Check that a P or D interrupt has a request to complete
+    bool device_interrupt_valid(const command& c) {
+        bool printer = c.type == 'P';
+        size_t devices = printer ? printer_queue.size() : disk_queue.size();
+        if(c.device > devices) {
+            if(printer) {
+                *log << "Requested Printer: " << c.device << " Available Printers: " << devices << '\n';
+                *log << "ERROR: Not valid printer" << '\n';
+            } else {
+                *log << "Requested Disk: " << c.device << " Available Disks: " << devices << '\n';
+                *log << "ERROR: Not valid disk" << '\n';
+            }
+            return false;
+        }
+        if(printer ? printer_rate : disk_rate) {
+            *log << (printer ? "ERROR: Printers are timed" : "ERROR: Disks are timed") << '\n';
+            return false;
+        }
+        if(device_front(printer ? printer_device : disk_device, c.device-1) == no_process) {
+            *log << (printer ? "ERROR: Printer queue is empty" : "ERROR: Disk queue is empty") << '\n';
+            return false;
+        }
+        return true;
+    }
+    //Request being served by device, no_process if it is idle
+    process_handle device_front(device_kind kind, unsigned int opt) const {
+        if(kind == printer_device)
+            return printer_queue[opt].empty() ? no_process : printer_queue[opt].front();
+        return disk_queue[opt].front();
+    }
+    //Send process finished on device back to ready_queue
+    //A disk moves its head on to the next request its policy picks
+    void complete_device(device_kind kind, unsigned int opt) {
+        process_handle h = device_front(kind, opt);
+        if(kind == printer_device)
+            printer_queue[opt].pop_front();
+        else {
+            disk& d = disk_queue[opt];
+            d.served++;
+            d.latency += clock - process_table.io_time[h];
+            d.pop();
+        }
+        process_table.status[h] = waiting;
+        process_table.ready_time[h] = clock;
+        *log << "Process " << process_table.pid[h] << " completed on "
+        << (kind == printer_device ? "Printer " : "Disk ") << opt+1 << '\n';
+        make_ready(h, wake_core(process_table.core[h]));
+    }
+    //Start serving the request at the head of a timed device
+    //A disk first seeks to the cylinder of the request
+    void start_device(device_kind kind, unsigned int opt) {
+        bool printer = kind == printer_device;
+        process_handle h = device_front(kind, opt);
+        device_stats& stats = printer ? printer_stats[opt] : disk_stats[opt];
+        stats.service_start = clock;
+        unsigned long long ticks = service_time(process_table.file_size[h], printer ? printer_rate : disk_rate);
+        if(!printer)
+            ticks += seek_time(disk_queue[opt].last_seek, seek_rate);
+        events.schedule(clock + ticks, device_event, opt, kind);
+    }
+    //Fire events up to time, in time order
+    void run_events(unsigned long long time) {
+        while (!events.empty() && events.next().time <= time) {
+            sim_event e = events.next();
+            events.pop();
+            fire(e);
+        }
+    }
+    //Print utilization, latency and throughput of timed devices
+    void device_report() {
+        *out << "Device statistics at time " << clock << ":" << '\n';
+        device_stats::print_header(*out);
+        if(printer_rate)
+            for(int i = 0; i < printer_stats.size(); i++)
+                printer_stats[i].print(*out, "printer " + std::to_string(i+1), clock);
+        if(disk_rate)
+            for(int i = 0; i < disk_stats.size(); i++)
+                disk_stats[i].print(*out, "disk" + std::to_string(i+1), clock);
+    }
+    //Print head position, seek distance and latency of every disk
+    void disk_report() {
+        std::ios::fmtflags flags = out->flags();
+        std::streamsize precision = out->precision();
+        *out << "Disk scheduling: " << disk_scheduling_name(disk_policy) << " Cylinders: " << cylinders << '\n';
+        *out << std::setw(15) << std::left << "Disk"
+        << std::setw(6) << std::left << "Head"
+        << std::setw(8) << std::left << "Served"
+        << std::setw(10) << std::left << "Seek"
+        << std::setw(10) << std::left << "Avg seek"
+        << "Avg latency" << '\n';
+        for (size_t i = 0; i < disk_queue.size(); i++) {
+            const disk& d = disk_queue[i];
+            *out << std::setw(15) << std::left << "disk" + std::to_string(i+1)
+            << std::setw(6) << std::left << d.head_position()
+            << std::setw(8) << std::left << d.served
+            << std::setw(10) << std::left << d.seek_distance
+            << std::setw(10) << std::left << std::fixed << std::setprecision(2) << (d.served ? (double)d.seek_distance / d.served : 0.0)
+            << (d.served ? (double)d.latency / d.served : 0.0) << '\n';
+        }
+        out->flags(flags);
+        out->precision(precision);
+    }
+    //Slide allocations together and move the processes with them
+    //Returns false if the allocator cannot compact
+    bool compact_memory() {
+        std::vector<memory_range> moved;
+        if(!memory_allocator->compact(moved))
+            return false;
+        for (size_t i = 0; i < moved.size(); i++) {
+            process_handle h = find_process(moved[i].pid);
+            if(h != no_process)
+                process_table.memory_base[h] = moved[i].base;
+        }
+        *log << "Compacted memory, moved " << moved.size() << " processes" << '\n';
+        return true;
+    }
+    //Print free space, fragmentation and compaction counters
+    void memory_report() {
+        memory_stats stats = memory_allocator->stats();
+        std::ios::fmtflags flags = out->flags();
+        std::streamsize precision = out->precision();
+        *out << "Holes: " << stats.holes << " Largest hole: " << stats.largest_hole
+        << " External fragmentation: " << std::fixed << std::setprecision(3) << stats.external_fragmentation() << '\n';
+        *out << "Failed allocations: " << stats.failures << " Compactions: " << stats.compactions;
+        if(stats.compactions)
+            *out << " Moved: " << stats.moved << " Time compacting: " << std::setprecision(6) << stats.compact_seconds << "s";
+        *out << '\n';
+        out->flags(flags);
+        out->precision(precision);
+    }
+    //Create process with its own memory and put it on ready_queue
+    //Returns no_process if there is not enough memory
+    process_handle create_process(unsigned int memory_amount, unsigned int priority, unsigned long long burst = 0) {
+        //Allocate memory for process before taking a pcb
+        int memory_base = memory_allocator->allocate_memory(pid_counter+1, memory_amount, compact_on_demand);
+        //No hole is big enough but the free space may be, the failure only counts if the retry fails too
+        if(memory_base == -1 && compact_on_demand) {
+            if(memory_allocator->stats().free >= memory_amount)
+                compact_memory();
+            memory_base = memory_allocator->allocate_memory(pid_counter+1, memory_amount);
+        }
+        if(memory_base == -1) {
+            *log << "ERROR: Not enough memory for process. Cancelling....\n" << '\n';
+            return no_process;
+        }
+        //Reuse pcb from pool with fresh pid
+        process_handle h = process_table.acquire();
+        process_table.pid[h] = ++pid_counter;
+        process_table.status[h] = waiting;
+        process_table.priority[h] = priority;
+        process_table.memory_base[h] = memory_base;
+        process_table.arrival_time[h] = clock;
+        process_table.ready_time[h] = clock;
+        process_table.wait_time[h] = 0;
+        process_table.burst_left[h] = burst;
+        //Process sucessfully created
+        processes.insert(pid_counter, h);
+        *log << "Created process with pid: " << pid_counter << '\n';
+        unsigned int cpu = wake_core(least_loaded_core());
+        process_table.core[h] = cpu;
+        cores[cpu].ready_queue->admit(h);
+        make_ready(h, cpu);
+        return h;
+    }
+    //Terminate process running on core and run the next one
+    void terminate_running(unsigned int cpu) {
+        process_handle h = cores[cpu].running_process;
+        charge_running(cpu);
+        pid_t pid = process_table.pid[h];
+        //Deallocate memory
+        memory_allocator->deallocate_memory(pid);
+        processes.erase(pid);
+        if(compact_threshold) {
+            memory_stats stats = memory_allocator->stats();
+            if(stats.holes > 1 && stats.external_fragmentation()*100 >= compact_threshold)
+                compact_memory();
+        }
+        *log << "Terminated process with pid: " << pid;
+        if(simulating) {
+            unsigned long long turnaround = clock - process_table.arrival_time[h];
+            *log << " turnaround: " << turnaround << " waiting: " << process_table.wait_time[h];
+            finished++;
+            total_turnaround += turnaround;
+            total_waiting += process_table.wait_time[h];
+        }
+        *log << '\n';
+        //Return used pcb to the pool
+        process_table.release(h);
+        //Run next process on ready_queue if there is one
+        release_core(cpu);
+    }
+    //Send process running on core to a device queue and run the next one
+    //Disk requests go to cylinder, printers ignore it
+    void request_device(unsigned int cpu, device_kind kind, unsigned int opt, uint32_t file_name, unsigned int file_size, unsigned int cylinder = 0) {
+        bool printer = kind == printer_device;
+        //Get running process and send next process to CPU
+        process_handle h = cores[cpu].running_process;
+        charge_running(cpu);
+        release_core(cpu);
+        //Set process information and send to device queue, the name's reference moves to the PCB
+        process_table.set_file_name(h, file_name);
+        process_table.file_size[h] = file_size;
+        process_table.status[h] = io;
+        process_table.io_time[h] = clock;
+        size_t queued;
+        if(printer) {
+            printer_queue[opt].push_back(h);
+            queued = printer_queue[opt].size();
+        } else {
+            disk_queue[opt].push(h, cylinder);
+            queued = disk_queue[opt].size();
+        }
+        (printer ? printer_stats[opt] : disk_stats[opt]).requests++;
+        *log << "Process " << process_table.pid[h] << " queued for " << (printer ? "Printer " : "Disk ") << opt+1 << '\n';
+        //Idle timed device starts on the request right away
+        if((printer ? printer_rate : disk_rate) && queued == 1)
+            start_device(kind, opt);
+    }
+    
+    //Apply one parsed command to the system
+    //Every command takes one tick, timed devices finish whatever is due first
+    void execute(const command& c) {
+        clock++;
+        run_events(clock);
+        switch (c.type) {
+            //Create process
+            case 'A': {
+                PCB_PROBE(probe_create);
+                create_process(c.memory_amount, c.priority);
+                break;
+            }
+            //Terminate running process
+            case 't': {
+                PCB_PROBE(probe_terminate);
+                //Check if any process is running
+                if(command_core() == cores.size()) {
+                    *log << "ERROR :No process to terminated" << '\n';
+                    break;
+                }
+                terminate_running(command_core());
+                break;
+            }
+            //Printer interrupt
+            case 'P': {
+                PCB_PROBE(probe_printer_interrupt);
+                if(device_interrupt_valid(c))
+                    complete_device(printer_device, c.device-1);
+                break;
+            }
+            //System call for a printer
+            case 'p': {
+                PCB_PROBE(probe_printer_request);
+                if(device_request_valid(c))
+                    request_device(command_core(), printer_device, c.device-1, process_table.file_names.intern(c.file_name), c.file_size);
+                break;
+            }
+            //Disk interrupt
+            case 'D': {
+                PCB_PROBE(probe_disk_interrupt);
+                if(device_interrupt_valid(c))
+                    complete_device(disk_device, c.device-1);
+                break;
+            }
+            //System call for a disk
+            case 'd': {
+                PCB_PROBE(probe_disk_request);
+                if(device_request_valid(c))
+                    request_device(command_core(), disk_device, c.device-1, process_table.file_names.intern(c.file_name), c.file_size, c.cylinder);
+                break;
+            }
+            //Snapshot interrupt
+            case 'S': {
+                PCB_PROBE(probe_snapshot);
+                switch(c.snapshot) {
+                    //Print out process on CPU and ready_queue processes
+                    case 'r': {
+                        *out << "Ready-queue status: " << '\n';
+                        *out << std::setw(5) << std::left << "pid"
+                        << std::setw(10) << std::left << "Priority"
+                        << std::setw(6) << std::left << "On CPU"<< '\n';
+                        for (size_t i = 0; i < cores.size(); i++) {
+                            const cpu_core& core = cores[i];
+                            if(cores.size() > 1)
+                                *out << "Core " << i+1 << ":" << '\n';
+                            if(core.running_process != no_process) {
+                                *out << std::setw(5) << std::left << process_table.pid[core.running_process]
+                                << std::setw(10) << std::left << process_table.priority[core.running_process]
+                                << std::setw(6) << std::left << "*"<< '\n';
+                            }
+                            core.ready_queue->for_each_ordered([this](process_handle h) {
+                                *out << std::setw(5) << std::left << process_table.pid[h]
+                                << std::setw(10) << std::left << process_table.priority[h] << '\n';
+                            });
+                        }
+                        *out << "Context switches: " << context_switches
+                        << " Preemptions: " << preemptions << '\n';
+                        if(cores.size() > 1)
+                            core_report();
+                        break;
+                    }
+                    //Print out device queues and information
+                    case 'i': {
+                        *out << std::setw(15) << std::left << "Device"
+                        << std::setw(5) << std::left << "pid"
+                        << std::setw(20) << std::left << "Filename"
+                        << std::setw(5) << "Filesize" << '\n';
+                        
+                        //Queues are walked in place, nothing is copied
+                        for(int i = 0; i < printer_queue.size(); i++) {
+                            std::string d_id = "printer " + std::to_string(i+1);
+                            for (std::deque<process_handle>::const_iterator h = printer_queue[i].begin(); h != printer_queue[i].end(); h++)
+                                print_request(d_id, *h);
+                        }
+                        //Request being served first, then the rest by cylinder
+                        for(int i = 0; i < disk_queue.size(); i++) {
+                            std::string d_id = "disk" + std::to_string(i+1);
+                            disk_queue[i].for_each([&](process_handle h, unsigned int) { print_request(d_id, h); });
+                        }
+                        if(printer_rate || disk_rate)
+                            device_report();
+                        if(!disk_queue.empty())
+                            disk_report();
+                        break;
+                    }
+                    //Print out memory allocations
+                    case 'm': {
+                        *out << "Memory Snapshot:" << '\n';
+                        memory_allocator->memory_snapshot(*out);
+                        if(paging == no_paging)
+                            memory_report();
+                        break;
+                    }
+                    //Print out latency histograms
+                    case 'h':
+                        latency_report();
+                        break;
+                }
+                export_stats(clock);
+                break;
+            }
+            default:
+                displayCommands();
+        }
+    }
+    //Write a stats record stamped with time, if stats are exported
+    void export_stats(unsigned long long time) {
+        if(!stats)
+            return;
+        record.clock = time;
+        record.context_switches = context_switches;
+        record.preemptions = preemptions;
+        record.finished = finished;
+        record.rejected = rejected;
+        record.events = events_fired;
+        record.cores.resize(cores.size());
+        for (size_t i = 0; i < cores.size(); i++) {
+            process_handle h = cores[i].running_process;
+            record.cores[i].running = h == no_process ? 0 : process_table.pid[h];
+            record.cores[i].ready = (uint32_t)cores[i].ready_queue->size();
+            record.cores[i].busy = cores[i].busy_time;
+        }
+        record.printers.resize(printer_queue.size());
+        for (size_t i = 0; i < printer_queue.size(); i++) {
+            process_handle h = device_front(printer_device, (unsigned int)i);
+            record.printers[i].serving = h == no_process ? 0 : process_table.pid[h];
+            record.printers[i].queued = (uint32_t)printer_queue[i].size();
+            record.printers[i].completed = printer_stats[i].completed;
+        }
+        record.disks.resize(disk_queue.size());
+        for (size_t i = 0; i < disk_queue.size(); i++) {
+            process_handle h = disk_queue[i].front();
+            record.disks[i].serving = h == no_process ? 0 : process_table.pid[h];
+            record.disks[i].queued = (uint32_t)disk_queue[i].size();
+            record.disks[i].completed = disk_stats[i].completed;
+        }
+        record.memory = memory_allocator->stats();
+        stats->write(record);
+    }
+    //Print latency histograms of the probed code paths
+    void latency_report() {
+#ifdef PCB_INSTRUMENT
+        probes().print(*out);
+#else
+        *out << "Latency histograms are not built in, compile with -DPCB_INSTRUMENT" << '\n';
+#endif
+    }
+    //One line of the S i device listing
+    void print_request(const std::string& device, process_handle h) {
+        *out << std::setw(15) << std::left << device
+        << std::setw(5) << std::left << process_table.pid[h]
+        << std::setw(20) << std::left << process_table.file_name_of(h)
+        << std::setw(5) << process_table.file_size[h] << '\n';
+    }
+    //Find live process by pid, no_process if there is none
+    process_handle find_process(pid_t pid) {
+        process_handle* h = processes.find(pid);
+        return h ? *h : no_process;
+    }
+    //Change priority of live process, returns false if there is none
+    bool change_priority(pid_t pid, unsigned int priority) {
+        process_handle h = find_process(pid);
+        if(h == no_process)
+            return false;
+        process_table.priority[h] = priority;
+        cores[process_table.core[h]].ready_queue->reprioritize(h);
+        updateCPU(process_table.core[h]);
+        return true;
+    }
+    //Display available commands
+    void displayCommands() {
+        *out << "Available Commands" << '\n';
+        *out << std::setw(15) << std::left << "A Ex: A will create new process" << '\n';
+        *out << std::setw(15) << std::left << "t Ex: t will terminate running process" << '\n';
+        *out << std::setw(15) << std::left << "P<device id> Ex: P3 will terminate process on printer 3" << '\n';
+        *out << std::setw(15) << std::left << "p<device id> Ex: p3 will send running process to printer 3" << '\n';
+        *out << std::setw(15) << std::left << "D<device id> Ex: D6 will terminate process on disk 6" << '\n';
+        *out << std::setw(15) << std::left << "d<device id> Ex: d6 will send running process to disk 6" << '\n';
+        *out << std::setw(15) << std::left << "S Ex: Snapshot" << '\n';
+    }
+    //Core the commands t, p and d act on, the first one running a process
+    //Returns cores.size() if all are idle
+    unsigned int command_core() const {
+        unsigned int cpu = 0;
+        while (cpu < cores.size() && cores[cpu].running_process == no_process)
+            cpu++;
+        return cpu;
+    }
+    //Core with the fewest running and ready processes
+    unsigned int least_loaded_core() const {
+        unsigned int best = 0;
+        size_t best_load = ~(size_t)0;
+        for (unsigned int i = 0; i < cores.size(); i++) {
+            size_t load = cores[i].ready_queue->size() + (cores[i].running_process != no_process);
+            if(load < best_load) {
+                best = i;
+                best_load = load;
+            }
+        }
+        return best;
+    }
+    //Core a process that becomes ready should go to
+    //Its own core unless that one is busy and another is idle
+    unsigned int wake_core(unsigned int cpu) const {
+        if(idle_cores == 0 || cores[cpu].running_process == no_process)
+            return cpu;
+        for (unsigned int i = 0; i < cores.size(); i++)
+            if(cores[i].running_process == no_process)
+                return i;
+        return cpu;
+    }
+    //Queue ready process on core and let the core reschedule
+    void make_ready(process_handle h, unsigned int cpu) {
+        if(process_table.core[h] != cpu)
+            migrate(h, cpu);
+        cores[cpu].ready_queue->push(h);
+        updateCPU(cpu);
+    }
+    //Take the CPU away from the running process of core and run the next one
+    void release_core(unsigned int cpu) {
+        cores[cpu].running_process = no_process;
+        idle_cores++;
+        updateCPU(cpu);
+    }
+    //Move the top of the longest other ready queue to idle core
+    //Returns false if every other ready queue is empty
+    bool steal(unsigned int cpu) {
+        unsigned int victim = cpu;
+        size_t longest = 0;
+        for (unsigned int i = 0; i < cores.size(); i++) {
+            if(i != cpu && cores[i].ready_queue->size() > longest) {
+                victim = i;
+                longest = cores[i].ready_queue->size();
+            }
+        }
+        if(longest == 0)
+            return false;
+        scheduler& from = *cores[victim].ready_queue;
+        process_handle h = from.top();
+        from.pop();
+        migrate(h, cpu);
+        cores[cpu].ready_queue->push(h);
+        return true;
+    }
+    //Move process that is not queued anywhere to core
+    //It starts over on the scheduler of its new core, like a new process
+    void migrate(process_handle h, unsigned int cpu) {
+        process_table.core[h] = cpu;
+        cores[cpu].ready_queue->admit(h);
+        cores[cpu].migrations++;
+    }
+    //Update core with the process the scheduler picks
+    //Idle core takes the top of its ready_queue, or steals one if that is empty
+    //Running process is first charged for the CPU it used, then the scheduler decides
+    //whether the top preempts it, in which case they swap places
+    void updateCPU(unsigned int cpu) {
+        PCB_PROBE(probe_update_cpu);
+        cpu_core& core = cores[cpu];
+        if(core.ready_queue->empty() && (core.running_process != no_process || !steal(cpu)))
+            return;
+        if(core.running_process == no_process) {
+            core.running_process = core.ready_queue->top();
+            core.ready_queue->pop();
+            idle_cores--;
+        }
+        else {
+            charge_running(cpu);
+            if(!core.ready_queue->preempts(core.running_process))
+                return;
+            process_handle h = core.running_process;
+            process_table.status[h] = waiting;
+            process_table.ready_time[h] = clock;
+            //Its pending burst event goes stale
+            process_table.burst_count[h]++;
+            core.running_process = core.ready_queue->replace_top(h);
+            preemptions++;
+        }
+        dispatch(cpu);
+    }
+    //Give the CPU of core to its running_process
+    void dispatch(unsigned int cpu) {
+        process_handle h = cores[cpu].running_process;
+        process_table.status[h] = running;
+        process_table.wait_time[h] += clock - process_table.ready_time[h];
+        process_table.dispatch_time[h] = clock;
+        context_switches++;
+        cores[cpu].dispatches++;
+        if(simulating)
+            schedule_burst(h);
+    }
+    //Schedule end of the running burst, or of the time slice if that is shorter
+    void schedule_burst(process_handle h) {
+        unsigned long long slice = process_table.burst_left[h];
+        unsigned long long limit = cores[process_table.core[h]].ready_queue->quantum(h);
+        if(limit && limit < slice)
+            slice = limit;
+        events.schedule(clock + slice, burst_event, h, ++process_table.burst_count[h]);
+    }
+    //Charge running process of core for the CPU it used since dispatch or the last charge
+    void charge_running(unsigned int cpu) {
+        cpu_core& core = cores[cpu];
+        process_handle h = core.running_process;
+        unsigned long long ran = clock - process_table.dispatch_time[h];
+        if(ran == 0)
+            return;
+        if(simulating) {
+            process_table.burst_left[h] -= ran;
+            memory_allocator->reference(process_table.pid[h], ran);
+        }
+        core.ready_queue->charge(h, ran);
+        core.busy_time += ran;
+        process_table.dispatch_time[h] = clock;
+    }
+};
+
+#endif /* os_h */
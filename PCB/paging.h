@@ -0,0 +1,409 @@
+//
+//  paging.h
+//  PCB
+//  CSCI 340 Project
+//
+//  Paged virtual memory with a TLB and page replacement
+//
+
+#ifndef paging_h
+#define paging_h
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <stdint.h>
+#include <sys/types.h>
+#include "memory.h"
+#include "pid_map.h"
+
+enum paging_policy {no_paging, fifo_paging, clock_paging, lru_paging};
+
+/*
+ frame_bitmap
+
+ One bit per physical frame, set while the frame holds a page
+ Free frames are found a 64-bit word at a time, starting from the word
+ where the last search stopped
+ */
+class frame_bitmap {
+    std::vector<uint64_t> words;
+    size_t frames = 0, used = 0, hint = 0;
+
+public:
+    static const uint32_t none = 0xffffffff;
+
+    void reset(size_t frames) {
+        this->frames = frames;
+        used = 0;
+        hint = 0;
+        words.assign((frames+63)/64, 0);
+        //Bits past the last frame are marked used so they are never handed out
+        if(frames % 64)
+            words.back() = ~0ull << (frames % 64);
+    }
+    size_t size() const {
+        return frames;
+    }
+    size_t free_frames() const {
+        return frames-used;
+    }
+    //Mark a free frame used and return it, none if all are used
+    uint32_t take() {
+        if(used == frames)
+            return none;
+        while (words[hint] == ~0ull)
+            hint = hint+1 == words.size() ? 0 : hint+1;
+        //Lowest clear bit of the word
+        unsigned int bit = __builtin_ctzll(~words[hint]);
+        words[hint] |= 1ull << bit;
+        used++;
+        return (uint32_t)(hint*64 + bit);
+    }
+    void release(uint32_t frame) {
+        words[frame/64] &= ~(1ull << (frame % 64));
+        used--;
+    }
+    //Number of runs of adjacent free frames and the length of the longest
+    void free_runs(size_t& runs, size_t& longest) const {
+        runs = longest = 0;
+        size_t run = 0;
+        for (size_t w = 0; w < words.size(); w++) {
+            //Whole words are free or used far more often than not
+            if(words[w] == 0) {
+                run += 64;
+                continue;
+            }
+            for (unsigned int bit = 0; bit < 64; bit++) {
+                if(!(words[w] >> bit & 1)) {
+                    run++;
+                    continue;
+                }
+                if(run) {
+                    runs++;
+                    longest = std::max(longest, run);
+                    run = 0;
+                }
+                if(words[w] >> bit == ~0ull >> bit)
+                    break;
+            }
+        }
+        if(run) {
+            runs++;
+            longest = std::max(longest, run);
+        }
+    }
+};
+
+/*
+ tlb
+
+ Set associative translation cache from (page table, page) to frame
+ Least recently used entry of a set is replaced on a miss
+ */
+class tlb {
+    static const unsigned int sets = 16, ways = 4;
+    struct entry {
+        uint32_t table = 0, page = 0, frame = 0;
+        unsigned long long used = 0;
+        bool valid = false;
+    };
+    entry entries[sets*ways];
+    unsigned long long clock = 0;
+
+    static unsigned int set_of(uint32_t table, uint32_t page) {
+        return (page ^ (table * 0x9E3779B9u)) % sets;
+    }
+
+public:
+    unsigned long long hits = 0, misses = 0;
+
+    //Frame of page, or frame_bitmap::none on a miss
+    uint32_t lookup(uint32_t table, uint32_t page) {
+        entry* set = entries + set_of(table, page)*ways;
+        for (unsigned int i = 0; i < ways; i++) {
+            if(set[i].valid && set[i].table == table && set[i].page == page) {
+                set[i].used = ++clock;
+                hits++;
+                return set[i].frame;
+            }
+        }
+        misses++;
+        return frame_bitmap::none;
+    }
+    void insert(uint32_t table, uint32_t page, uint32_t frame) {
+        entry* set = entries + set_of(table, page)*ways;
+        entry* victim = set;
+        for (unsigned int i = 0; i < ways && victim->valid; i++)
+            if(!set[i].valid || set[i].used < victim->used)
+                victim = set+i;
+        victim->table = table;
+        victim->page = page;
+        victim->frame = frame;
+        victim->used = ++clock;
+        victim->valid = true;
+    }
+    void invalidate(uint32_t table, uint32_t page) {
+        entry* set = entries + set_of(table, page)*ways;
+        for (unsigned int i = 0; i < ways; i++)
+            if(set[i].valid && set[i].table == table && set[i].page == page)
+                set[i].valid = false;
+    }
+    //Drop every entry of a page table
+    void flush(uint32_t table) {
+        for (unsigned int i = 0; i < sets*ways; i++)
+            if(entries[i].table == table)
+                entries[i].valid = false;
+    }
+    static unsigned int capacity() {
+        return sets*ways;
+    }
+};
+
+/*
+ paged_memory
+
+ Every process gets its own address space of fixed size pages, so a process fits
+ as long as its pages do not outnumber the frames, however scattered the free frames are
+ Pages are loaded on first reference, and a full memory evicts a page by the paging policy:
+ fifo   oldest loaded page
+ clock  second chance, reference bits are set on every reference
+ lru    least recently used, recency is only updated on TLB misses the way an os
+        only sees the referenced bit when it walks the page table, so it approximates LRU
+ Running processes touch one page per tick, sweeping through their pages in order
+ */
+class paged_memory : public memory_manager {
+    static const uint32_t not_resident = 0xffffffff;
+    struct page_table {
+        pid_t pid = 0;
+        std::vector<uint32_t> frames;
+        uint32_t resident = 0, cursor = 0;
+    };
+    unsigned int memory_cap, page_size;
+    paging_policy policy;
+    frame_bitmap frames;
+    //Page table and page each frame holds
+    std::vector<uint32_t> frame_table, frame_page;
+    std::vector<page_table> tables;
+    std::vector<uint32_t> free_tables;
+    pid_map<uint32_t> tables_by_pid;
+    tlb cache;
+    //clock reference bits and hand
+    std::vector<bool> referenced;
+    uint32_t hand = 0;
+    //fifo and lru list of resident frames through arrays indexed by frame, most recent at the head
+    //fifo only links a frame when it is loaded, lru also moves it up when it is referenced
+    //Freed frames are unlinked, so the list never holds more than the frames
+    std::vector<uint32_t> newer, older;
+    uint32_t most_recent = frame_bitmap::none, least_recent = frame_bitmap::none;
+    unsigned long long references = 0, faults = 0, evictions = 0, failures = 0;
+
+    void unlink(uint32_t frame) {
+        if(newer[frame] == frame_bitmap::none)
+            most_recent = older[frame];
+        else
+            older[newer[frame]] = older[frame];
+        if(older[frame] == frame_bitmap::none)
+            least_recent = newer[frame];
+        else
+            newer[older[frame]] = newer[frame];
+    }
+    void push_recent(uint32_t frame) {
+        newer[frame] = frame_bitmap::none;
+        older[frame] = most_recent;
+        if(most_recent == frame_bitmap::none)
+            least_recent = frame;
+        else
+            newer[most_recent] = frame;
+        most_recent = frame;
+    }
+    //Frame to evict by the paging policy
+    uint32_t victim() {
+        switch (policy) {
+            case clock_paging:
+                while (referenced[hand]) {
+                    referenced[hand] = false;
+                    hand = hand+1 == frames.size() ? 0 : hand+1;
+                }
+                return hand;
+            default:
+                return least_recent;
+        }
+    }
+    //Take frame away from the page it holds
+    void unmap(uint32_t frame) {
+        page_table& owner = tables[frame_table[frame]];
+        owner.frames[frame_page[frame]] = not_resident;
+        owner.resident--;
+        cache.invalidate(frame_table[frame], frame_page[frame]);
+        if(policy != clock_paging)
+            unlink(frame);
+        frames.release(frame);
+    }
+    //Load page into a frame, evicting one if memory is full
+    uint32_t load(uint32_t table, uint32_t page) {
+        faults++;
+        uint32_t frame = frames.take();
+        if(frame == frame_bitmap::none) {
+            unmap(victim());
+            evictions++;
+            frame = frames.take();
+        }
+        frame_table[frame] = table;
+        frame_page[frame] = page;
+        tables[table].frames[page] = frame;
+        tables[table].resident++;
+        if(policy != clock_paging)
+            push_recent(frame);
+        referenced[frame] = true;
+        return frame;
+    }
+    void touch(uint32_t table, uint32_t page) {
+        references++;
+        uint32_t frame = cache.lookup(table, page);
+        if(frame == frame_bitmap::none) {
+            frame = tables[table].frames[page];
+            if(frame == not_resident)
+                frame = load(table, page);
+            else if(policy == lru_paging) {
+                unlink(frame);
+                push_recent(frame);
+            }
+            cache.insert(table, page, frame);
+        }
+        referenced[frame] = true;
+    }
+
+public:
+    paged_memory(unsigned int memory_cap, unsigned int page_size, paging_policy policy)
+    : memory_cap(memory_cap), page_size(page_size ? page_size : 1), policy(policy) {
+        size_t count = memory_cap / this->page_size;
+        frames.reset(count);
+        frame_table.assign(count, 0);
+        frame_page.assign(count, 0);
+        referenced.assign(count, false);
+        newer.assign(count, (uint32_t)frame_bitmap::none);
+        older.assign(count, (uint32_t)frame_bitmap::none);
+    }
+    //Create the address space of a process, nothing is loaded until it is referenced
+    //Returns virtual start 0, or -1 if amount is 0 or the process has more pages than there are frames
+    int allocate_memory(pid_t pid, unsigned int amount, bool retry = false) {
+        PCB_PROBE(probe_allocate);
+        size_t pages = (amount + (size_t)page_size - 1) / page_size;
+        if(amount == 0 || pages > frames.size()) {
+            if(!retry)
+                failures++;
+            return -1;
+        }
+        uint32_t table;
+        if(free_tables.empty()) {
+            table = (uint32_t)tables.size();
+            tables.push_back(page_table());
+        } else {
+            table = free_tables.back();
+            free_tables.pop_back();
+        }
+        tables[table].pid = pid;
+        tables[table].frames.assign(pages, (uint32_t)not_resident);
+        tables[table].resident = 0;
+        tables[table].cursor = 0;
+        tables_by_pid.insert(pid, table);
+        return 0;
+    }
+    bool deallocate_memory(pid_t pid) {
+        PCB_PROBE(probe_deallocate);
+        uint32_t* found = tables_by_pid.find(pid);
+        if(!found)
+            return false;
+        uint32_t table = *found;
+        tables_by_pid.erase(pid);
+        page_table& t = tables[table];
+        for (size_t page = 0; page < t.frames.size() && t.resident > 0; page++)
+            if(t.frames[page] != not_resident)
+                unmap(t.frames[page]);
+        cache.flush(table);
+        t.frames.clear();
+        free_tables.push_back(table);
+        return true;
+    }
+    //Free frames are the free space and runs of them the holes, though any free frame can take any page
+    memory_stats stats() const {
+        memory_stats s;
+        size_t runs, longest;
+        frames.free_runs(runs, longest);
+        s.free = (unsigned int)(frames.free_frames() * page_size);
+        s.largest_hole = (unsigned int)(longest * page_size);
+        s.holes = (unsigned int)runs;
+        s.failures = failures;
+        return s;
+    }
+    //Process ran for ticks, one page reference per tick
+    //At most one pass over its pages is simulated per call
+    void reference(pid_t pid, unsigned long long ticks) {
+        uint32_t* found = tables_by_pid.find(pid);
+        if(!found)
+            return;
+        uint32_t table = *found;
+        size_t pages = tables[table].frames.size();
+        if(pages == 0)
+            return;
+        ticks = std::min<unsigned long long>(ticks, pages);
+        for (unsigned long long i = 0; i < ticks; i++) {
+            uint32_t page = tables[table].cursor;
+            tables[table].cursor = page+1 == pages ? 0 : page+1;
+            touch(table, page);
+        }
+    }
+    void memory_snapshot(std::ostream& out) {
+        out << std::setw(5) << std::left << "pid"
+        << std::setw(8) << std::left << "Pages"
+        << "Resident" << '\n';
+        std::vector<std::pair<pid_t, uint32_t>> processes;
+        processes.reserve(tables_by_pid.size());
+        tables_by_pid.for_each([&processes](pid_t pid, uint32_t table) { processes.push_back(std::make_pair(pid, table)); });
+        std::sort(processes.begin(), processes.end());
+        for (size_t i = 0; i < processes.size(); i++) {
+            const page_table& t = tables[processes[i].second];
+            out << std::setw(5) << std::left << processes[i].first
+            << std::setw(8) << std::left << t.frames.size()
+            << t.resident << '\n';
+        }
+        std::ios::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+        out << "Frames: " << frames.size() << " Page size: " << page_size << " Free frames: " << frames.free_frames() << '\n';
+        out << "References: " << references << " Page faults: " << faults << " Evictions: " << evictions << '\n';
+        out << "TLB entries: " << tlb::capacity() << " Hits: " << cache.hits << " Misses: " << cache.misses
+        << " Hit rate: " << std::fixed << std::setprecision(3)
+        << (references ? (double)cache.hits / references : 0.0) << '\n';
+        out.flags(flags);
+        out.precision(precision);
+    }
+};
+
+//Name of paging policy
+inline const char* paging_name(paging_policy policy) {
+    const char* names[] = {"none", "fifo", "clock", "lru"};
+    return names[policy];
+}
+//Read paging policy name, returns false if it is not one
+inline bool parse_paging(const char* s, size_t n, paging_policy& policy) {
+    for (int i = 0; i < 4; i++) {
+        const char* name = paging_name((paging_policy)i);
+        if(std::char_traits<char>::length(name) == n && std::char_traits<char>::compare(name, s, n) == 0) {
+            policy = (paging_policy)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+//Create allocator, paged unless policy is no_paging
+inline memory_manager* make_memory(placement_policy placement, paging_policy paging, unsigned int memory_cap, unsigned int page_size) {
+    if(paging == no_paging)
+        return make_memory(placement, memory_cap);
+    return new paged_memory(memory_cap, page_size, paging);
+}
+
+#endif /* paging_h */
@@ -0,0 +1,126 @@
+//
+//  pid_map.h
+//  PCB
+//  CSCI 340 Project
+//
+//  Flat hash map from pid to value
+//
+
+#ifndef pid_map_h
+#define pid_map_h
+
+#include <vector>
+#include <cstddef>
+#include <sys/types.h>
+
+/*
+ pid_map
+
+ Open addressing with linear probing over one array
+ pid 0 is never handed out by the os so it marks an empty slot
+ Erase shifts the following entries back instead of leaving tombstones,
+ so lookups stay short under heavy create and terminate churn
+ Pointers returned by find are invalidated by insert and erase
+ */
+template <class value_type>
+class pid_map {
+public:
+    struct slot {
+        pid_t pid;
+        value_type value;
+    };
+
+private:
+    std::vector<slot> slots;
+    size_t count = 0;
+    size_t mask = 0;
+
+    //Fibonacci hashing spreads sequential pids across the table
+    size_t home(pid_t pid) const {
+        return (size_t)(((unsigned long long)(unsigned int)pid * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    }
+    void grow() {
+        std::vector<slot> old;
+        old.swap(slots);
+        size_t capacity = old.empty() ? 16 : old.size()*2;
+        slots.assign(capacity, slot());
+        for (size_t i = 0; i < capacity; i++)
+            slots[i].pid = 0;
+        mask = capacity-1;
+        count = 0;
+        for (size_t i = 0; i < old.size(); i++)
+            if(old[i].pid != 0)
+                insert(old[i].pid, old[i].value);
+    }
+
+public:
+    size_t size() const {
+        return count;
+    }
+    bool empty() const {
+        return count == 0;
+    }
+    void clear() {
+        for (size_t i = 0; i < slots.size(); i++)
+            slots[i].pid = 0;
+        count = 0;
+    }
+    //Value stored for pid or nullptr
+    value_type* find(pid_t pid) {
+        if(slots.empty())
+            return nullptr;
+        for (size_t i = home(pid); slots[i].pid != 0; i = (i+1) & mask)
+            if(slots[i].pid == pid)
+                return &slots[i].value;
+        return nullptr;
+    }
+    const value_type* find(pid_t pid) const {
+        return const_cast<pid_map*>(this)->find(pid);
+    }
+    //Insert or overwrite value for pid
+    value_type& insert(pid_t pid, const value_type& value) {
+        //Keep load factor under 1/2
+        if((count+1)*2 > slots.size())
+            grow();
+        size_t i = home(pid);
+        while (slots[i].pid != 0 && slots[i].pid != pid)
+            i = (i+1) & mask;
+        if(slots[i].pid == 0)
+            count++;
+        slots[i].pid = pid;
+        slots[i].value = value;
+        return slots[i].value;
+    }
+    //Remove pid, returns false if it was not present
+    bool erase(pid_t pid) {
+        if(slots.empty())
+            return false;
+        size_t i = home(pid);
+        while (slots[i].pid != pid) {
+            if(slots[i].pid == 0)
+                return false;
+            i = (i+1) & mask;
+        }
+        //Shift back every following entry whose home is not between the hole and itself
+        size_t hole = i;
+        for (size_t j = (i+1) & mask; slots[j].pid != 0; j = (j+1) & mask) {
+            size_t h = home(slots[j].pid);
+            if(((j - h) & mask) >= ((j - hole) & mask)) {
+                slots[hole] = slots[j];
+                hole = j;
+            }
+        }
+        slots[hole].pid = 0;
+        count--;
+        return true;
+    }
+    //Visit every entry in table order
+    template <class visitor>
+    void for_each(visitor visit) const {
+        for (size_t i = 0; i < slots.size(); i++)
+            if(slots[i].pid != 0)
+                visit(slots[i].pid, slots[i].value);
+    }
+};
+
+#endif /* pid_map_h */
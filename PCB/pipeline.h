@@ -0,0 +1,224 @@
+//
+//  pipeline.h
+//  PCB
+//  CSCI 340 Project
+//
+//  Lock-free single producer single consumer ring and the output stage of pipelined batch runs
+//
+
+#ifndef pipeline_h
+#define pipeline_h
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <iomanip>
+#include <streambuf>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+
+//Times one side of a ring found it full or empty, and how long it waited in nanoseconds
+struct ring_waits {
+    unsigned long long count = 0, ns = 0;
+};
+
+/*
+ spsc_ring
+
+ Bounded queue between exactly one producer thread and one consumer thread
+ Slots are filled and drained in place, claim and publish on the producer side,
+ front and pop on the consumer side, so records are never copied through the ring
+ A full ring makes the producer wait and an empty one the consumer, which is the backpressure
+ Each side keeps its own index and a cached copy of the other's on its own cache line,
+ and only reloads the other's index when the cached one says the ring is full or empty
+ */
+template <class type>
+class spsc_ring {
+    std::vector<type> slots;
+    size_t mask;
+    char pad0[64];
+    //Producer side
+    std::atomic<size_t> tail;
+    size_t cached_head = 0;
+    ring_waits full;
+    char pad1[64];
+    //Consumer side
+    std::atomic<size_t> head;
+    size_t cached_tail = 0;
+    ring_waits empty;
+    char pad2[64];
+    std::atomic<bool> closed;
+
+    static uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+public:
+    //Capacity is rounded up to a power of two
+    spsc_ring(size_t capacity) : tail(0), head(0), closed(false) {
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        slots.resize(size);
+        mask = size-1;
+    }
+    //Producer: slot to fill next, waits while the ring is full
+    type* claim() {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if(t - cached_head > mask) {
+            cached_head = head.load(std::memory_order_acquire);
+            if(t - cached_head > mask) {
+                uint64_t start = now();
+                full.count++;
+                while (t - (cached_head = head.load(std::memory_order_acquire)) > mask)
+                    std::this_thread::yield();
+                full.ns += now() - start;
+            }
+        }
+        return &slots[t & mask];
+    }
+    //Producer: hand the claimed slot to the consumer
+    void publish() {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    //Producer: nothing more is coming
+    void close() {
+        closed.store(true, std::memory_order_release);
+    }
+    //Consumer: oldest published slot, waits while the ring is empty
+    //Returns nullptr once the ring is closed and drained
+    type* front() {
+        size_t h = head.load(std::memory_order_relaxed);
+        if(h == cached_tail) {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if(h == cached_tail) {
+                uint64_t start = now();
+                empty.count++;
+                while (h == (cached_tail = tail.load(std::memory_order_acquire))) {
+                    //Slots published before close are seen once closed is
+                    if(closed.load(std::memory_order_acquire) && h == (cached_tail = tail.load(std::memory_order_acquire))) {
+                        empty.ns += now() - start;
+                        return nullptr;
+                    }
+                    std::this_thread::yield();
+                }
+                empty.ns += now() - start;
+            }
+        }
+        return &slots[h & mask];
+    }
+    //Consumer: give the front slot back to the producer
+    void pop() {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    //Only read once both sides are done
+    const ring_waits& full_waits() const {
+        return full;
+    }
+    const ring_waits& empty_waits() const {
+        return empty;
+    }
+};
+
+/*
+ output_chunk
+
+ Block of formatted output on its way to the writer thread
+ */
+struct output_chunk {
+    size_t length;
+    char data[4096 - sizeof(size_t)];
+};
+
+/*
+ output_pipe
+
+ Stream buffer that formats into chunks claimed straight from a ring
+ A chunk is published when it fills up or the stream is flushed,
+ so the thread formatting never waits on the terminal or a file
+ */
+class output_pipe : public std::streambuf {
+    spsc_ring<output_chunk>& ring;
+    output_chunk* chunk = nullptr;
+
+    void ship() {
+        if(!chunk || pptr() == pbase())
+            return;
+        chunk->length = pptr() - pbase();
+        ring.publish();
+        chunk = nullptr;
+        setp(nullptr, nullptr);
+    }
+
+protected:
+    int_type overflow(int_type c) {
+        ship();
+        if(!chunk) {
+            chunk = ring.claim();
+            setp(chunk->data, chunk->data + sizeof(chunk->data));
+        }
+        if(!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+    int sync() {
+        ship();
+        return 0;
+    }
+
+public:
+    output_pipe(spsc_ring<output_chunk>& ring) : ring(ring) {}
+    //Publish what is left and tell the writer nothing more is coming
+    void close() {
+        ship();
+        ring.close();
+    }
+};
+
+/*
+ stage_counters
+
+ Work done by one pipeline stage, and how often and how long it waited on a neighbour
+ */
+struct stage_counters {
+    const char* name;
+    const char* unit;
+    unsigned long long items = 0, stalls = 0, stall_ns = 0;
+    double seconds = 0;
+
+    stage_counters(const char* name, const char* unit) : name(name), unit(unit) {}
+    void add_waits(const ring_waits& w) {
+        stalls += w.count;
+        stall_ns += w.ns;
+    }
+};
+
+//Print items, throughput and stalls of every stage
+inline void pipeline_report(std::ostream& out, const stage_counters* stages, size_t count) {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << "Pipeline:" << '\n';
+    out << std::setw(10) << std::left << "Stage"
+    << std::setw(18) << std::left << "Items"
+    << std::setw(10) << std::left << "Seconds"
+    << std::setw(14) << std::left << "Items/sec"
+    << std::setw(9) << std::left << "Stalls"
+    << "Stalled s" << '\n';
+    for (size_t i = 0; i < count; i++) {
+        const stage_counters& s = stages[i];
+        out << std::setw(10) << std::left << s.name
+        << std::setw(18) << std::left << (std::to_string(s.items) + " " + s.unit)
+        << std::setw(10) << std::left << std::fixed << std::setprecision(3) << s.seconds
+        << std::setw(14) << std::left << std::setprecision(0) << (s.seconds > 0 ? s.items / s.seconds : 0.0)
+        << std::setw(9) << std::left << s.stalls
+        << std::setprecision(3) << s.stall_ns / 1e9 << '\n';
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+#endif /* pipeline_h */
@@ -0,0 +1,135 @@
+//
+//  process.h
+//  PCB
+//  CSCI 340 Project
+//
+//  Process control blocks and the pool they live in
+//
+
+#ifndef process_h
+#define process_h
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include <sys/types.h>
+#include "string_pool.h"
+
+//Enum for status of process
+enum proces_status : unsigned char {waiting, running, terminated, io};
+
+//Index of a PCB in the process pool, stays valid while the pool grows
+typedef uint32_t process_handle;
+const process_handle no_process = 0xffffffff;
+
+/*
+ process_pool
+
+ Process control blocks stored as a structure of arrays
+ Contains pid, priority,
+ starting memory location,
+ status, file name and file_size
+ Every field is its own array indexed by handle, so a scan over one field
+ streams through contiguous memory. File names are interned once
+ Terminated PCBs go on a free list and their slots are handed out again
+ Everything is released at once when the pool is destroyed
+ */
+class process_pool {
+    std::vector<process_handle> free_slots;
+
+public:
+    std::vector<pid_t> pid;
+    std::vector<unsigned int> priority;
+    std::vector<unsigned int> memory_base;
+    std::vector<proces_status> status;
+    std::vector<unsigned int> file_size;
+    //Id in file_names, string_pool::none before the first device request
+    //Each live PCB holds one reference to its name
+    std::vector<uint32_t> file_name;
+    string_pool file_names;
+    //Clock when the process was queued on its device
+    std::vector<unsigned long long> io_time;
+    //Clock when the process arrived, last entered ready_queue and last got the CPU
+    std::vector<unsigned long long> arrival_time, ready_time, dispatch_time;
+    //Total time spent in ready_queue
+    std::vector<unsigned long long> wait_time;
+    //Simulated CPU time left in the current burst and number of bursts scheduled so far
+    std::vector<unsigned long long> burst_left;
+    std::vector<uint32_t> burst_count;
+    //Core the process runs or is queued on
+    std::vector<unsigned int> core;
+
+    //Get a PCB, reusing a released slot when there is one
+    process_handle acquire() {
+        if(free_slots.empty()) {
+            pid.push_back(0);
+            priority.push_back(0);
+            memory_base.push_back(0);
+            status.push_back(waiting);
+            file_size.push_back(0);
+            file_name.push_back((uint32_t)string_pool::none);
+            io_time.push_back(0);
+            arrival_time.push_back(0);
+            ready_time.push_back(0);
+            dispatch_time.push_back(0);
+            wait_time.push_back(0);
+            burst_left.push_back(0);
+            burst_count.push_back(0);
+            core.push_back(0);
+            return (process_handle)(pid.size()-1);
+        }
+        process_handle h = free_slots.back();
+        free_slots.pop_back();
+        return h;
+    }
+    //Released slots in the order they are handed out again, last first
+    const std::vector<process_handle>& free_list() const {
+        return free_slots;
+    }
+    void set_free_list(const std::vector<process_handle>& slots) {
+        free_slots = slots;
+    }
+    //Return PCB to the pool
+    void release(process_handle h) {
+        status[h] = terminated;
+        set_file_name(h, (uint32_t)string_pool::none);
+        free_slots.push_back(h);
+    }
+    //Give the PCB a reference to name, dropping the one to its last name
+    void set_file_name(process_handle h, uint32_t name) {
+        file_names.release(file_name[h]);
+        file_name[h] = name;
+    }
+    //Name of the last file the process sent to a device
+    const std::string& file_name_of(process_handle h) const {
+        return file_names[file_name[h]];
+    }
+    //Number of slots, live and free
+    size_t capacity() const {
+        return pid.size();
+    }
+    //Number of live PCBs
+    size_t size() const {
+        return pid.size()-free_slots.size();
+    }
+    void clear() {
+        pid.clear();
+        priority.clear();
+        memory_base.clear();
+        status.clear();
+        file_size.clear();
+        file_name.clear();
+        file_names.clear();
+        io_time.clear();
+        arrival_time.clear();
+        ready_time.clear();
+        dispatch_time.clear();
+        wait_time.clear();
+        burst_left.clear();
+        burst_count.clear();
+        core.clear();
+        free_slots.clear();
+    }
+};
+
+#endif /* process_h */
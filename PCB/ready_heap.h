@@ -0,0 +1,182 @@
+//
+//  ready_heap.h
+//  PCB
+//  CSCI 340 Project
+//
+//  Addressable priority queue of processes waiting for the CPU
+//
+
+#ifndef ready_heap_h
+#define ready_heap_h
+
+#include <vector>
+#include <algorithm>
+#include "process.h"
+
+/*
+ ready_heap
+
+ Indexed binary heap of process handles
+ Lower priority value runs first, earlier arrival breaks ties
+ Entries keep a copy of the priority so sifting never touches the PCB
+ Heap slot of every handle is kept in a vector indexed by handle so a
+ process can be removed or reprioritized in O(log n) without searching for it
+ */
+class ready_heap {
+    struct entry {
+        unsigned int priority;
+        process_handle h;
+        unsigned long long arrival;
+    };
+    static const unsigned int not_queued = 0xffffffff;
+    std::vector<entry> heap;
+    std::vector<unsigned int> slots;
+    unsigned long long arrivals = 0;
+    //Reused by ordered iteration
+    mutable std::vector<unsigned int> frontier;
+
+    static bool before(const entry& a, const entry& b) {
+        if(a.priority != b.priority)
+            return a.priority < b.priority;
+        return a.arrival < b.arrival;
+    }
+    void place(unsigned int i, const entry& e) {
+        heap[i] = e;
+        slots[e.h] = i;
+    }
+    void sift_up(unsigned int i) {
+        entry e = heap[i];
+        while (i > 0) {
+            unsigned int parent = (i-1)/2;
+            if(!before(e, heap[parent]))
+                break;
+            place(i, heap[parent]);
+            i = parent;
+        }
+        place(i, e);
+    }
+    void sift_down(unsigned int i) {
+        entry e = heap[i];
+        unsigned int n = (unsigned int)heap.size();
+        while (true) {
+            unsigned int child = 2*i+1;
+            if(child >= n)
+                break;
+            if(child+1 < n && before(heap[child+1], heap[child]))
+                child++;
+            if(!before(heap[child], e))
+                break;
+            place(i, heap[child]);
+            i = child;
+        }
+        place(i, e);
+    }
+    //Remove entry in slot i
+    void remove(unsigned int i) {
+        slots[heap[i].h] = not_queued;
+        entry last = heap.back();
+        heap.pop_back();
+        if(i == heap.size())
+            return;
+        heap[i] = last;
+        slots[last.h] = i;
+        if(i > 0 && before(last, heap[(i-1)/2]))
+            sift_up(i);
+        else
+            sift_down(i);
+    }
+    void track(process_handle h) {
+        if(h >= slots.size())
+            slots.resize(h+1, (unsigned int)not_queued);
+    }
+
+public:
+    bool empty() const {
+        return heap.empty();
+    }
+    size_t size() const {
+        return heap.size();
+    }
+    bool contains(process_handle h) const {
+        return h < slots.size() && slots[h] != not_queued;
+    }
+    //Highest priority process
+    process_handle top() const {
+        return heap.front().h;
+    }
+    void push(process_handle h, unsigned int priority) {
+        track(h);
+        entry e = {priority, h, arrivals++};
+        heap.push_back(e);
+        sift_up((unsigned int)heap.size()-1);
+    }
+    void pop() {
+        remove(0);
+    }
+    //Pop top and push h with a single sift, returns the old top
+    process_handle replace_top(process_handle h, unsigned int priority) {
+        track(h);
+        process_handle old = heap.front().h;
+        slots[old] = not_queued;
+        entry e = {priority, h, arrivals++};
+        heap[0] = e;
+        sift_down(0);
+        return old;
+    }
+    //Remove process, returns false if it is not queued
+    bool erase(process_handle h) {
+        if(!contains(h))
+            return false;
+        remove(slots[h]);
+        return true;
+    }
+    //Change priority of queued process, returns false if it is not queued
+    bool change_priority(process_handle h, unsigned int priority) {
+        if(!contains(h))
+            return false;
+        unsigned int i = slots[h];
+        unsigned int old = heap[i].priority;
+        heap[i].priority = priority;
+        if(priority < old)
+            sift_up(i);
+        else
+            sift_down(i);
+        return true;
+    }
+    //Visit queued processes in priority order without modifying the heap
+    //Walks the heap best first from the root, O(k log k) for the first k processes
+    template <class visitor>
+    void for_each_ordered(visitor visit) const {
+        if(heap.empty())
+            return;
+        frontier.clear();
+        frontier.push_back(0);
+        //Comparison for a min heap of slots in std heap order
+        struct later {
+            const std::vector<entry>& heap;
+            bool operator()(unsigned int a, unsigned int b) const { return before(heap[b], heap[a]); }
+        } order = {heap};
+        while (!frontier.empty()) {
+            std::pop_heap(frontier.begin(), frontier.end(), order);
+            unsigned int i = frontier.back();
+            frontier.pop_back();
+            visit(heap[i].h);
+            for (unsigned int child = 2*i+1; child <= 2*i+2 && child < heap.size(); child++) {
+                frontier.push_back(child);
+                std::push_heap(frontier.begin(), frontier.end(), order);
+            }
+        }
+    }
+    //Visit queued processes in heap order
+    template <class visitor>
+    void for_each(visitor visit) const {
+        for (size_t i = 0; i < heap.size(); i++)
+            visit(heap[i].h);
+    }
+    void clear() {
+        heap.clear();
+        slots.clear();
+    }
+};
+
+#endif /* ready_heap_h */
@@ -0,0 +1,462 @@
+//
+//  scheduler.h
+//  PCB
+//  CSCI 340 Project
+//
+//  Scheduling policies behind the ready queue
+//
+
+#ifndef scheduler_h
+#define scheduler_h
+
+#include <vector>
+#include <set>
+#include <utility>
+#include <string>
+#include <algorithm>
+#include <functional>
+#include <stdint.h>
+#include "process.h"
+#include "ready_heap.h"
+
+enum scheduling_policy {priority_scheduling, round_robin_scheduling, mlfq_scheduling, srtf_scheduling, cfs_scheduling};
+
+/*
+ scheduler
+
+ Ready queue of processes waiting for the CPU and the rules for picking the next one
+ The os calls charge with the CPU time the running process used before
+ it asks whether the top of the queue preempts it
+ Time slices only run out in simulation mode, where the CPU time of a process is known
+ */
+class scheduler {
+protected:
+    const process_pool& pcbs;
+
+public:
+    scheduler(const process_pool& pcbs) : pcbs(pcbs) {}
+    virtual ~scheduler() {}
+    virtual bool empty() const = 0;
+    virtual size_t size() const = 0;
+    //Process that runs next
+    virtual process_handle top() const = 0;
+    virtual void pop() = 0;
+    //Queue process that became ready
+    virtual void push(process_handle h) = 0;
+    //Remove queued process, returns false if it is not queued
+    virtual bool erase(process_handle h) = 0;
+    //Pop top and push h, returns the old top
+    virtual process_handle replace_top(process_handle h) {
+        process_handle next = top();
+        pop();
+        push(h);
+        return next;
+    }
+    //True if top should take the CPU from the running process
+    virtual bool preempts(process_handle running) const = 0;
+    //Reset per process state of a new process
+    virtual void admit(process_handle h) {}
+    //Longest time slice of running process, 0 for no limit
+    virtual unsigned long long quantum(process_handle h) const {
+        return 0;
+    }
+    //Running process used ran ticks of CPU
+    virtual void charge(process_handle h, unsigned long long ran) {}
+    //Time slice of running process ran out before its burst did
+    virtual void expire(process_handle h) {}
+    //Priority of process changed
+    virtual void reprioritize(process_handle h) {}
+    //Visit queued processes in the order they would run, without copying the queue
+    virtual void for_each_ordered(const std::function<void(process_handle)>& visit) const = 0;
+    //Policy state that is not in the queue order, for checkpoints
+    virtual void save(std::vector<uint64_t>& state) const {}
+    //Restore saved state into an empty scheduler, before the queue is pushed again in order
+    //Every one of handles PCBs gets per process state, returns false if state is not one save writes
+    virtual bool load(const uint64_t* state, size_t count, size_t handles) {
+        return count == 0;
+    }
+};
+
+/*
+ run_lists
+
+ FIFO lists of process handles linked through arrays indexed by handle
+ A handle is on at most one list, so push, pop and erase are O(1)
+ */
+class run_lists {
+    static const unsigned char not_listed = 0xff;
+    std::vector<process_handle> next, prev, head, tail;
+    std::vector<unsigned char> list_of;
+    size_t count = 0;
+
+    void track(process_handle h) {
+        if(h >= next.size()) {
+            next.resize(h+1, no_process);
+            prev.resize(h+1, no_process);
+            list_of.resize(h+1, (unsigned char)not_listed);
+        }
+    }
+
+public:
+    run_lists(unsigned int lists) : head(lists, no_process), tail(lists, no_process) {}
+    bool empty(unsigned int list) const {
+        return head[list] == no_process;
+    }
+    size_t size() const {
+        return count;
+    }
+    process_handle front(unsigned int list) const {
+        return head[list];
+    }
+    //List h is on, lists() if it is not on any
+    unsigned int list(process_handle h) const {
+        return h < list_of.size() && list_of[h] != not_listed ? list_of[h] : (unsigned int)head.size();
+    }
+    unsigned int lists() const {
+        return (unsigned int)head.size();
+    }
+    void push_back(unsigned int list, process_handle h) {
+        track(h);
+        next[h] = no_process;
+        prev[h] = tail[list];
+        if(tail[list] == no_process)
+            head[list] = h;
+        else
+            next[tail[list]] = h;
+        tail[list] = h;
+        list_of[h] = (unsigned char)list;
+        count++;
+    }
+    //Remove h, returns false if it is not on a list
+    bool erase(process_handle h) {
+        unsigned int l = list(h);
+        if(l == head.size())
+            return false;
+        if(prev[h] == no_process)
+            head[l] = next[h];
+        else
+            next[prev[h]] = next[h];
+        if(next[h] == no_process)
+            tail[l] = prev[h];
+        else
+            prev[next[h]] = prev[h];
+        list_of[h] = not_listed;
+        count--;
+        return true;
+    }
+    template <class visitor>
+    void for_each(unsigned int list, visitor visit) const {
+        for (process_handle h = head[list]; h != no_process; h = next[h])
+            visit(h);
+    }
+};
+
+/*
+ priority_scheduler
+
+ Static priority, lower value runs first and preempts a running process of higher value
+ */
+class priority_scheduler : public scheduler {
+    ready_heap heap;
+
+public:
+    priority_scheduler(const process_pool& pcbs) : scheduler(pcbs) {}
+    bool empty() const {
+        return heap.empty();
+    }
+    size_t size() const {
+        return heap.size();
+    }
+    process_handle top() const {
+        return heap.top();
+    }
+    void pop() {
+        heap.pop();
+    }
+    void push(process_handle h) {
+        heap.push(h, pcbs.priority[h]);
+    }
+    bool erase(process_handle h) {
+        return heap.erase(h);
+    }
+    //Single sift instead of a pop and a push
+    process_handle replace_top(process_handle h) {
+        return heap.replace_top(h, pcbs.priority[h]);
+    }
+    bool preempts(process_handle running) const {
+        return pcbs.priority[heap.top()] < pcbs.priority[running];
+    }
+    void reprioritize(process_handle h) {
+        heap.change_priority(h, pcbs.priority[h]);
+    }
+    void for_each_ordered(const std::function<void(process_handle)>& visit) const {
+        heap.for_each_ordered(visit);
+    }
+};
+
+/*
+ round_robin
+
+ First come first served with a time slice, a process whose slice runs out goes to the back
+ */
+class round_robin : public scheduler {
+    run_lists queue;
+    unsigned long long slice;
+
+public:
+    round_robin(const process_pool& pcbs, unsigned long long slice) : scheduler(pcbs), queue(1), slice(slice) {}
+    bool empty() const {
+        return queue.empty(0);
+    }
+    size_t size() const {
+        return queue.size();
+    }
+    process_handle top() const {
+        return queue.front(0);
+    }
+    void pop() {
+        queue.erase(queue.front(0));
+    }
+    void push(process_handle h) {
+        queue.push_back(0, h);
+    }
+    bool erase(process_handle h) {
+        return queue.erase(h);
+    }
+    bool preempts(process_handle running) const {
+        return false;
+    }
+    unsigned long long quantum(process_handle h) const {
+        return slice;
+    }
+    void for_each_ordered(const std::function<void(process_handle)>& visit) const {
+        queue.for_each(0, visit);
+    }
+};
+
+/*
+ mlfq
+
+ Multi-level feedback queue
+ New processes start on the top level, a process that uses its whole slice drops a level
+ and a process that gives up the CPU early keeps its level
+ Every level down doubles the slice, lower levels only run when the ones above are empty
+ A higher level process preempts a lower level one
+ There is no periodic boost, so a steady stream of short jobs can starve the bottom level
+ */
+class mlfq : public scheduler {
+    static const unsigned int levels = 4;
+    run_lists queues;
+    std::vector<unsigned char> level;
+    unsigned long long slice;
+
+    //Highest non-empty level, levels if all are empty
+    unsigned int top_level() const {
+        unsigned int l = 0;
+        while (l < levels && queues.empty(l))
+            l++;
+        return l;
+    }
+
+public:
+    mlfq(const process_pool& pcbs, unsigned long long slice) : scheduler(pcbs), queues(levels), slice(slice) {}
+    bool empty() const {
+        return queues.size() == 0;
+    }
+    size_t size() const {
+        return queues.size();
+    }
+    process_handle top() const {
+        return queues.front(top_level());
+    }
+    void pop() {
+        queues.erase(top());
+    }
+    void push(process_handle h) {
+        queues.push_back(level[h], h);
+    }
+    bool erase(process_handle h) {
+        return queues.erase(h);
+    }
+    bool preempts(process_handle running) const {
+        return top_level() < level[running];
+    }
+    void admit(process_handle h) {
+        if(h >= level.size())
+            level.resize(h+1, 0);
+        level[h] = 0;
+    }
+    unsigned long long quantum(process_handle h) const {
+        return slice << level[h];
+    }
+    void expire(process_handle h) {
+        if(level[h]+1 < levels)
+            level[h]++;
+    }
+    //Level of every process
+    void save(std::vector<uint64_t>& state) const {
+        state.assign(level.begin(), level.end());
+    }
+    bool load(const uint64_t* state, size_t count, size_t handles) {
+        for (size_t i = 0; i < count; i++)
+            if(state[i] >= levels)
+                return false;
+        level.assign(state, state + count);
+        if(level.size() < handles)
+            level.resize(handles, 0);
+        return true;
+    }
+    void for_each_ordered(const std::function<void(process_handle)>& visit) const {
+        for (unsigned int l = 0; l < levels; l++)
+            queues.for_each(l, visit);
+    }
+};
+
+/*
+ srtf
+
+ Shortest remaining time first
+ Ordered by what is left of the current CPU burst, a process with less left preempts the running one
+ Outside simulation mode bursts are unknown and it is first come first served
+ */
+class srtf : public scheduler {
+    ready_heap heap;
+
+    unsigned int remaining(process_handle h) const {
+        return (unsigned int)std::min<unsigned long long>(pcbs.burst_left[h], 0xffffffffu);
+    }
+
+public:
+    srtf(const process_pool& pcbs) : scheduler(pcbs) {}
+    bool empty() const {
+        return heap.empty();
+    }
+    size_t size() const {
+        return heap.size();
+    }
+    process_handle top() const {
+        return heap.top();
+    }
+    void pop() {
+        heap.pop();
+    }
+    void push(process_handle h) {
+        heap.push(h, remaining(h));
+    }
+    bool erase(process_handle h) {
+        return heap.erase(h);
+    }
+    process_handle replace_top(process_handle h) {
+        return heap.replace_top(h, remaining(h));
+    }
+    bool preempts(process_handle running) const {
+        return pcbs.burst_left[heap.top()] < pcbs.burst_left[running];
+    }
+    void for_each_ordered(const std::function<void(process_handle)>& visit) const {
+        heap.for_each_ordered(visit);
+    }
+};
+
+/*
+ cfs
+
+ Completely fair scheduling, the process that has had the least weighted CPU time runs next
+ Virtual runtime grows by the CPU time used times priority+1, so priority acts as a nice value
+ Queued processes are kept in a red-black tree (std::set) keyed by virtual runtime
+ New and waking processes start no lower than the smallest virtual runtime picked so far,
+ so sleeping does not bank CPU time
+ A running process is preempted once it is a whole slice ahead of the top
+ */
+class cfs : public scheduler {
+    typedef std::pair<unsigned long long, process_handle> key;
+    std::set<key> tree;
+    std::vector<unsigned long long> vruntime;
+    unsigned long long min_vruntime = 0;
+    unsigned long long slice;
+
+public:
+    cfs(const process_pool& pcbs, unsigned long long slice) : scheduler(pcbs), slice(slice) {}
+    bool empty() const {
+        return tree.empty();
+    }
+    size_t size() const {
+        return tree.size();
+    }
+    process_handle top() const {
+        return tree.begin()->second;
+    }
+    void pop() {
+        min_vruntime = std::max(min_vruntime, tree.begin()->first);
+        tree.erase(tree.begin());
+    }
+    void push(process_handle h) {
+        vruntime[h] = std::max(vruntime[h], min_vruntime);
+        tree.insert(key(vruntime[h], h));
+    }
+    bool erase(process_handle h) {
+        return h < vruntime.size() && tree.erase(key(vruntime[h], h)) > 0;
+    }
+    bool preempts(process_handle running) const {
+        return tree.begin()->first + slice < vruntime[running];
+    }
+    void admit(process_handle h) {
+        if(h >= vruntime.size())
+            vruntime.resize(h+1, 0);
+        vruntime[h] = min_vruntime;
+    }
+    unsigned long long quantum(process_handle h) const {
+        return slice;
+    }
+    void charge(process_handle h, unsigned long long ran) {
+        vruntime[h] += ran * (pcbs.priority[h] + 1ull);
+    }
+    //min_vruntime, then the virtual runtime of every process
+    void save(std::vector<uint64_t>& state) const {
+        state.assign(1, min_vruntime);
+        state.insert(state.end(), vruntime.begin(), vruntime.end());
+    }
+    bool load(const uint64_t* state, size_t count, size_t handles) {
+        if(count == 0)
+            return false;
+        min_vruntime = state[0];
+        vruntime.assign(state + 1, state + count);
+        if(vruntime.size() < handles)
+            vruntime.resize(handles, 0);
+        return true;
+    }
+    void for_each_ordered(const std::function<void(process_handle)>& visit) const {
+        for (std::set<key>::const_iterator i = tree.begin(); i != tree.end(); i++)
+            visit(i->second);
+    }
+};
+
+//Name of scheduling policy
+inline const char* scheduling_name(scheduling_policy policy) {
+    const char* names[] = {"priority", "rr", "mlfq", "srtf", "cfs"};
+    return names[policy];
+}
+//Read scheduling policy name, returns false if it is not one
+inline bool parse_scheduling(const char* s, size_t n, scheduling_policy& policy) {
+    for (int i = 0; i < 5; i++) {
+        const char* name = scheduling_name((scheduling_policy)i);
+        if(std::char_traits<char>::length(name) == n && std::char_traits<char>::compare(name, s, n) == 0) {
+            policy = (scheduling_policy)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+//Create ready queue for policy
+//slice is the time quantum of rr and cfs and of the top level of mlfq
+inline scheduler* make_scheduler(scheduling_policy policy, const process_pool& pcbs, unsigned long long slice) {
+    switch (policy) {
+        case round_robin_scheduling: return new round_robin(pcbs, slice);
+        case mlfq_scheduling: return new mlfq(pcbs, slice);
+        case srtf_scheduling: return new srtf(pcbs);
+        case cfs_scheduling: return new cfs(pcbs, slice);
+        default: return new priority_scheduler(pcbs);
+    }
+}
+
+#endif /* scheduler_h */
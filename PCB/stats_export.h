@@ -0,0 +1,204 @@
+//
+//  stats_export.h
+//  PCB
+//  CSCI 340 Project
+//
+//  Machine readable snapshots of the simulator for monitoring
+//
+
+#ifndef stats_export_h
+#define stats_export_h
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "memory.h"
+
+enum stats_format {json_stats, binary_stats};
+
+//Name of stats format
+inline const char* stats_format_name(stats_format format) {
+    const char* names[] = {"json", "binary"};
+    return names[format];
+}
+//Read stats format name, returns false if it is not one
+inline bool parse_stats_format(const char* s, size_t n, stats_format& format) {
+    for (int i = 0; i < 2; i++) {
+        const char* name = stats_format_name((stats_format)i);
+        if(std::char_traits<char>::length(name) == n && std::char_traits<char>::compare(name, s, n) == 0) {
+            format = (stats_format)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ stats_record
+
+ State of the simulator at one point in time
+ The os refills the same record every time, so its vectors keep their capacity
+ pids are 0 for an idle core or device
+ */
+struct stats_record {
+    struct core_sample {
+        uint32_t running, ready;
+        uint64_t busy;
+    };
+    struct device_sample {
+        uint32_t serving, queued;
+        uint64_t completed;
+    };
+    uint64_t clock = 0, context_switches = 0, preemptions = 0, finished = 0, rejected = 0, events = 0;
+    std::vector<core_sample> cores;
+    std::vector<device_sample> printers, disks;
+    memory_stats memory;
+};
+
+/*
+ stats_writer
+
+ Writes stats records to a stream, one write call per record
+ Every record is flushed as soon as it is written, with the stream buffer empty beforehand,
+ so it reaches the file in one piece and a reader following the file never sees half a record
+ json    one object per line:
+         {"clock":..,"context_switches":..,"preemptions":..,"finished":..,"rejected":..,"events":..,
+          "cores":[{"running":..,"ready":..,"busy":..}],
+          "printers":[{"serving":..,"queued":..,"completed":..}],"disks":[..],
+          "memory":{"free":..,"holes":..,"largest_hole":..,"failures":..,"compactions":..}}
+ binary  "OSST" and a uint32 version once, then per record in host byte order:
+         uint32 size of the rest of the record
+         uint64 clock, context_switches, preemptions, finished, rejected, events
+         uint32 cores, then per core uint32 running, uint32 ready, uint64 busy
+         uint32 printers, then per printer uint32 serving, uint32 queued, uint64 completed
+         uint32 disks, then the same per disk
+         uint32 free, holes, largest_hole, uint64 failures, compactions
+ Records are built in a reused buffer without going through stream formatting
+ */
+class stats_writer {
+    static const uint32_t version = 1;
+    std::ostream& out;
+    stats_format format;
+    std::string buffer;
+    bool started = false;
+
+    void append(const char* s) {
+        buffer += s;
+    }
+    void append_uint(uint64_t value) {
+        char digits[20];
+        int n = 0;
+        do {
+            digits[n++] = '0' + value % 10;
+            value /= 10;
+        } while (value);
+        while (n > 0)
+            buffer += digits[--n];
+    }
+    void append_field(const char* name, uint64_t value, bool first = false) {
+        if(!first)
+            buffer += ',';
+        buffer += '"';
+        buffer += name;
+        append("\":");
+        append_uint(value);
+    }
+    template <class type>
+    void append_raw(type value) {
+        buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    void append_devices(const char* name, const std::vector<stats_record::device_sample>& devices) {
+        buffer += ",\"";
+        buffer += name;
+        append("\":[");
+        for (size_t i = 0; i < devices.size(); i++) {
+            append(i ? ",{" : "{");
+            append_field("serving", devices[i].serving, true);
+            append_field("queued", devices[i].queued);
+            append_field("completed", devices[i].completed);
+            buffer += '}';
+        }
+        buffer += ']';
+    }
+    void append_raw_devices(const std::vector<stats_record::device_sample>& devices) {
+        append_raw((uint32_t)devices.size());
+        for (size_t i = 0; i < devices.size(); i++) {
+            append_raw(devices[i].serving);
+            append_raw(devices[i].queued);
+            append_raw(devices[i].completed);
+        }
+    }
+
+    void write_json(const stats_record& r) {
+        buffer += '{';
+        append_field("clock", r.clock, true);
+        append_field("context_switches", r.context_switches);
+        append_field("preemptions", r.preemptions);
+        append_field("finished", r.finished);
+        append_field("rejected", r.rejected);
+        append_field("events", r.events);
+        append(",\"cores\":[");
+        for (size_t i = 0; i < r.cores.size(); i++) {
+            append(i ? ",{" : "{");
+            append_field("running", r.cores[i].running, true);
+            append_field("ready", r.cores[i].ready);
+            append_field("busy", r.cores[i].busy);
+            buffer += '}';
+        }
+        buffer += ']';
+        append_devices("printers", r.printers);
+        append_devices("disks", r.disks);
+        append(",\"memory\":{");
+        append_field("free", r.memory.free, true);
+        append_field("holes", r.memory.holes);
+        append_field("largest_hole", r.memory.largest_hole);
+        append_field("failures", r.memory.failures);
+        append_field("compactions", r.memory.compactions);
+        append("}}\n");
+    }
+    void write_binary(const stats_record& r) {
+        if(!started) {
+            append("OSST");
+            append_raw(version);
+        }
+        size_t size_at = buffer.size();
+        append_raw((uint32_t)0);
+        append_raw(r.clock);
+        append_raw(r.context_switches);
+        append_raw(r.preemptions);
+        append_raw(r.finished);
+        append_raw(r.rejected);
+        append_raw(r.events);
+        append_raw((uint32_t)r.cores.size());
+        for (size_t i = 0; i < r.cores.size(); i++) {
+            append_raw(r.cores[i].running);
+            append_raw(r.cores[i].ready);
+            append_raw(r.cores[i].busy);
+        }
+        append_raw_devices(r.printers);
+        append_raw_devices(r.disks);
+        append_raw((uint32_t)r.memory.free);
+        append_raw((uint32_t)r.memory.holes);
+        append_raw((uint32_t)r.memory.largest_hole);
+        append_raw((uint64_t)r.memory.failures);
+        append_raw((uint64_t)r.memory.compactions);
+        uint32_t size = (uint32_t)(buffer.size() - size_at - sizeof(uint32_t));
+        buffer.replace(size_at, sizeof(size), reinterpret_cast<const char*>(&size), sizeof(size));
+    }
+
+public:
+    stats_writer(std::ostream& out, stats_format format) : out(out), format(format) {}
+    void write(const stats_record& r) {
+        buffer.clear();
+        if(format == json_stats)
+            write_json(r);
+        else
+            write_binary(r);
+        started = true;
+        out.write(buffer.data(), buffer.size());
+        out.flush();
+    }
+};
+
+#endif /* stats_export_h */
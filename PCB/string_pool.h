@@ -0,0 +1,171 @@
+//
+//  string_pool.h
+//  PCB
+//  CSCI 340 Project
+//
+//  Interned strings referred to by 32-bit id
+//
+
+#ifndef string_pool_h
+#define string_pool_h
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <stdint.h>
+
+/*
+ string_pool
+
+ Every distinct string is stored once and referred to by its id
+ Lookup is an open addressing table of ids keyed by FNV-1a hash,
+ so interning a name that was seen before does not allocate
+ Ids are reference counted, every intern hands the caller one reference
+ Once the last one is released the string is dropped and its id reused,
+ so a long run with ever new names only keeps the ones still in use
+ */
+class string_pool {
+    static const uint32_t empty_slot = 0xffffffff;
+    std::vector<std::string> strings;
+    std::vector<uint32_t> references;
+    std::vector<uint32_t> free_ids;
+    std::vector<uint32_t> table;
+    size_t mask = 0;
+    size_t live = 0;
+
+    static uint32_t hash(const char* s, size_t n) {
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < n; i++) {
+            h ^= (unsigned char)s[i];
+            h *= 16777619u;
+        }
+        return h;
+    }
+    void place(uint32_t id) {
+        size_t i = hash(strings[id].data(), strings[id].size()) & mask;
+        while (table[i] != empty_slot)
+            i = (i+1) & mask;
+        table[i] = id;
+    }
+    void grow() {
+        size_t capacity = table.empty() ? 64 : table.size()*2;
+        table.assign(capacity, (uint32_t)empty_slot);
+        mask = capacity-1;
+        for (uint32_t id = 0; id < strings.size(); id++)
+            if(references[id])
+                place(id);
+    }
+    //Take id out of the table, shifting back the entries that probed past it
+    void unlink(uint32_t id) {
+        size_t i = hash(strings[id].data(), strings[id].size()) & mask;
+        while (table[i] != id)
+            i = (i+1) & mask;
+        size_t hole = i;
+        while (true) {
+            i = (i+1) & mask;
+            if(table[i] == empty_slot)
+                break;
+            size_t home = hash(strings[table[i]].data(), strings[table[i]].size()) & mask;
+            //Entry can move back if its home is not between the hole and where it sits
+            if(((i - home) & mask) >= ((i - hole) & mask)) {
+                table[hole] = table[i];
+                hole = i;
+            }
+        }
+        table[hole] = empty_slot;
+    }
+
+public:
+    //Id that names no string
+    static const uint32_t none = 0xffffffff;
+
+    //Id of string with one more reference, adding it if it is new
+    uint32_t intern(const char* s, size_t n) {
+        if((live+1)*2 > table.size())
+            grow();
+        size_t i = hash(s, n) & mask;
+        while (table[i] != empty_slot) {
+            const std::string& existing = strings[table[i]];
+            if(existing.size() == n && std::memcmp(existing.data(), s, n) == 0) {
+                references[table[i]]++;
+                return table[i];
+            }
+            i = (i+1) & mask;
+        }
+        uint32_t id;
+        if(free_ids.empty()) {
+            id = (uint32_t)strings.size();
+            strings.push_back(std::string(s, n));
+            references.push_back(1);
+        } else {
+            id = free_ids.back();
+            free_ids.pop_back();
+            strings[id].assign(s, n);
+            references[id] = 1;
+        }
+        table[i] = id;
+        live++;
+        return id;
+    }
+    uint32_t intern(const std::string& s) {
+        return intern(s.data(), s.size());
+    }
+    //One more reference to id
+    void retain(uint32_t id) {
+        references[id]++;
+    }
+    //Drop one reference to id, the last one frees it
+    void release(uint32_t id) {
+        if(id == none || --references[id] > 0)
+            return;
+        unlink(id);
+        std::string().swap(strings[id]);
+        free_ids.push_back(id);
+        live--;
+    }
+    const std::string& operator[](uint32_t id) const {
+        return strings[id];
+    }
+    //Number of ids, live and free, a free id holds an empty string
+    size_t size() const {
+        return strings.size();
+    }
+    //Strings in use
+    size_t count() const {
+        return live;
+    }
+    void clear() {
+        strings.clear();
+        references.clear();
+        free_ids.clear();
+        table.clear();
+        mask = 0;
+        live = 0;
+    }
+    //Put back the strings of a checkpoint under their old ids, all without references
+    //Every holder then retains its id and prune frees the rest
+    void restore(const char* text, const uint32_t* lengths, size_t count) {
+        clear();
+        for (size_t i = 0, at = 0; i < count; at += lengths[i], i++) {
+            strings.push_back(std::string(text + at, lengths[i]));
+            references.push_back(0);
+        }
+    }
+    void prune() {
+        free_ids.clear();
+        live = 0;
+        for (uint32_t id = (uint32_t)strings.size(); id-- > 0; ) {
+            if(references[id])
+                live++;
+            else {
+                std::string().swap(strings[id]);
+                free_ids.push_back(id);
+            }
+        }
+        table.clear();
+        while (live*2 > table.size() || table.empty())
+            grow();
+    }
+};
+
+#endif /* string_pool_h */
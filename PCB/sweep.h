@@ -0,0 +1,184 @@
+//
+//  sweep.h
+//  PCB
+//  CSCI 340 Project
+//
+//  Parameter sweeps run on a pool of host threads
+//
+
+#ifndef sweep_h
+#define sweep_h
+
+#include <vector>
+#include <string>
+#include <istream>
+#include <streambuf>
+#include <thread>
+#include <atomic>
+#include "lexer.h"
+#include "memory.h"
+#include "paging.h"
+#include "scheduler.h"
+
+/*
+ sweep_spec
+
+ Values to try for every setup parameter, one line per parameter:
+ memory 1024 4096
+ printers 1 2
+ disks 2
+ placement first best
+ scheduling priority rr cfs
+ cores 1 4
+ paging none lru
+ Every combination is one run. Parameters that are left out keep a single default
+ */
+struct sweep_spec {
+    std::vector<unsigned int> memory, printers, disks, cores;
+    std::vector<placement_policy> placement;
+    std::vector<scheduling_policy> scheduling;
+    std::vector<paging_policy> paging;
+
+    size_t runs() const {
+        return memory.size() * printers.size() * disks.size() * placement.size() * scheduling.size() * cores.size() * paging.size();
+    }
+};
+
+/*
+ sweep_point
+
+ Setup of one run of a sweep
+ */
+struct sweep_point {
+    unsigned int memory, printers, disks, cores;
+    placement_policy placement;
+    scheduling_policy scheduling;
+    paging_policy paging;
+};
+
+//Setup of run i, the last parameter varies fastest
+inline sweep_point sweep_at(const sweep_spec& spec, size_t i) {
+    sweep_point p;
+    p.paging = spec.paging[i % spec.paging.size()];
+    i /= spec.paging.size();
+    p.cores = spec.cores[i % spec.cores.size()];
+    i /= spec.cores.size();
+    p.scheduling = spec.scheduling[i % spec.scheduling.size()];
+    i /= spec.scheduling.size();
+    p.placement = spec.placement[i % spec.placement.size()];
+    i /= spec.placement.size();
+    p.disks = spec.disks[i % spec.disks.size()];
+    i /= spec.disks.size();
+    p.printers = spec.printers[i % spec.printers.size()];
+    i /= spec.printers.size();
+    p.memory = spec.memory[i % spec.memory.size()];
+    return p;
+}
+
+//Read sweep spec, returns false and the line number on an invalid line
+inline bool parse_sweep(std::istream& in, sweep_spec& spec, size_t& line_number) {
+    const size_t max_tokens = 64;
+    token tokens[max_tokens];
+    std::string line;
+    line_number = 0;
+    while (std::getline(in, line)) {
+        line_number++;
+        size_t count = lexer::tokenize(line.data(), line.size(), tokens, max_tokens);
+        if(count == 0 || tokens[0].text[0] == '#')
+            continue;
+        if(count < 2 || count > max_tokens)
+            return false;
+        std::string name = tokens[0].str();
+        for (size_t i = 1; i < count; i++) {
+            const token& t = tokens[i];
+            unsigned int value;
+            placement_policy placement;
+            scheduling_policy scheduling;
+            paging_policy paging;
+            if(name == "placement" && parse_placement(t.text, t.length, placement))
+                spec.placement.push_back(placement);
+            else if(name == "scheduling" && parse_scheduling(t.text, t.length, scheduling))
+                spec.scheduling.push_back(scheduling);
+            else if(name == "paging" && parse_paging(t.text, t.length, paging))
+                spec.paging.push_back(paging);
+            else if(!lexer::parse_uint(t, value))
+                return false;
+            else if(name == "memory")
+                spec.memory.push_back(value);
+            else if(name == "printers")
+                spec.printers.push_back(value);
+            else if(name == "disks")
+                spec.disks.push_back(value);
+            else if(name == "cores" && value > 0)
+                spec.cores.push_back(value);
+            else
+                return false;
+        }
+    }
+    if(spec.memory.empty())
+        spec.memory.push_back(1024);
+    if(spec.printers.empty())
+        spec.printers.push_back(1);
+    if(spec.disks.empty())
+        spec.disks.push_back(1);
+    if(spec.placement.empty())
+        spec.placement.push_back(worst_fit_placement);
+    if(spec.scheduling.empty())
+        spec.scheduling.push_back(priority_scheduling);
+    if(spec.cores.empty())
+        spec.cores.push_back(1);
+    if(spec.paging.empty())
+        spec.paging.push_back(no_paging);
+    return true;
+}
+
+/*
+ text_buffer
+
+ Read only stream buffer over text owned by someone else
+ Lets every run read the same workload without copying it
+ */
+class text_buffer : public std::streambuf {
+public:
+    text_buffer(const std::string& text) {
+        char* begin = const_cast<char*>(text.data());
+        setg(begin, begin, begin + text.size());
+    }
+};
+
+/*
+ run_parallel
+
+ Calls run(i, results) for i in [0, jobs) on threads host threads
+ Threads take the next job from a shared atomic counter, so long runs do not hold up short ones
+ Every thread appends to its own buffer, padded to its own cache line,
+ and the buffers are only merged once all threads are done
+ run must only touch state of its own job
+ */
+template <class result, class job>
+std::vector<result> run_parallel(size_t jobs, unsigned int threads, job run) {
+    struct buffer {
+        std::vector<result> results;
+        char pad[64];
+    };
+    if(threads == 0)
+        threads = 1;
+    std::vector<buffer> buffers(threads);
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> pool;
+    for (unsigned int t = 0; t < threads; t++) {
+        pool.push_back(std::thread([&, t]() {
+            for (size_t i = next++; i < jobs; i = next++)
+                run(i, buffers[t].results);
+        }));
+    }
+    for (size_t t = 0; t < pool.size(); t++)
+        pool[t].join();
+    std::vector<result> merged;
+    merged.reserve(jobs);
+    for (size_t t = 0; t < buffers.size(); t++)
+        merged.insert(merged.end(), buffers[t].results.begin(), buffers[t].results.end());
+    return merged;
+}
+
+#endif /* sweep_h */
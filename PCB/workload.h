@@ -0,0 +1,299 @@
+//
+//  workload.h
+//  PCB
+//  CSCI 340 Project
+//
+//  Seeded synthetic workloads and batch traces
+//
+
+#ifndef workload_h
+#define workload_h
+
+#include <vector>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <cmath>
+#include <algorithm>
+#include <stdint.h>
+#include "lexer.h"
+#include "memory.h"
+#include "scheduler.h"
+
+enum size_distribution {uniform_sizes, zipf_sizes, bimodal_sizes};
+
+//Name of memory size distribution
+inline const char* size_distribution_name(size_distribution sizes) {
+    const char* names[] = {"uniform", "zipf", "bimodal"};
+    return names[sizes];
+}
+//Read memory size distribution name, returns false if it is not one
+inline bool parse_size_distribution(const char* s, size_t n, size_distribution& sizes) {
+    for (int i = 0; i < 3; i++) {
+        const char* name = size_distribution_name((size_distribution)i);
+        if(std::char_traits<char>::length(name) == n && std::char_traits<char>::compare(name, s, n) == 0) {
+            sizes = (size_distribution)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ workload_spec
+
+ Knobs of a synthetic workload, one line per parameter in a spec file:
+ seed 340
+ processes 10000
+ arrival_rate 0.04     mean arrivals per tick
+ priorities 10         priorities are 0 to priorities-1
+ priority_skew 1.0     zipf exponent towards priority 0, 0 for uniform
+ sizes zipf            uniform, zipf or bimodal memory sizes
+ memory_size 16 512    smallest and largest process
+ size_skew 1.0         zipf exponent towards the smallest size
+ large_share 0.2       share of bimodal sizes from the top quarter of the range
+ device_requests 1.5   mean device requests per process, before the cap of eight
+ printer_share 0.5     share of device requests that go to a printer
+ file_size 1 64
+ burst 1 20            CPU burst length in ticks
+ files 64              distinct file names
+ setup 65536 2 2 worst priority 1   placement and scheduling must be ones the simulator knows
+ */
+struct workload_spec {
+    uint64_t seed = 340;
+    unsigned int processes = 10000;
+    double arrival_rate = 0.04;
+    unsigned int priorities = 10;
+    double priority_skew = 0.0;
+    size_distribution sizes = uniform_sizes;
+    unsigned int min_memory = 16, max_memory = 512;
+    double size_skew = 1.0, large_share = 0.2;
+    double device_requests = 1.5, printer_share = 0.5;
+    unsigned int min_file_size = 1, max_file_size = 64;
+    unsigned int min_burst = 1, max_burst = 20;
+    unsigned int files = 64;
+    unsigned int memory = 65536, printers = 2, disks = 2;
+    placement_policy placement = worst_fit_placement;
+    scheduling_policy scheduling = priority_scheduling;
+    unsigned int cores = 1;
+};
+
+//Read workload spec, returns false and the line number on an invalid line
+//Parameters that are left out keep their defaults
+inline bool parse_workload_spec(std::istream& in, workload_spec& spec, size_t& line_number) {
+    const size_t max_tokens = 8;
+    token tokens[max_tokens];
+    std::string line;
+    line_number = 0;
+    while (std::getline(in, line)) {
+        line_number++;
+        size_t count = lexer::tokenize(line.data(), line.size(), tokens, max_tokens);
+        if(count == 0 || tokens[0].text[0] == '#')
+            continue;
+        std::string name = tokens[0].str();
+        unsigned int a = 0, b = 0;
+        bool one = count == 2 && lexer::parse_uint(tokens[1], a);
+        bool two = count == 3 && lexer::parse_uint(tokens[1], a) && lexer::parse_uint(tokens[2], b) && a <= b;
+        double real = count == 2 ? std::atof(tokens[1].str().c_str()) : -1;
+        if(name == "seed" && one)
+            spec.seed = a;
+        else if(name == "processes" && one)
+            spec.processes = a;
+        else if(name == "arrival_rate" && real > 0)
+            spec.arrival_rate = real;
+        else if(name == "priorities" && one && a > 0)
+            spec.priorities = a;
+        else if(name == "priority_skew" && real >= 0)
+            spec.priority_skew = real;
+        else if(name == "sizes" && count == 2 && parse_size_distribution(tokens[1].text, tokens[1].length, spec.sizes))
+            continue;
+        else if(name == "memory_size" && two && a > 0) {
+            spec.min_memory = a;
+            spec.max_memory = b;
+        }
+        else if(name == "size_skew" && real >= 0)
+            spec.size_skew = real;
+        else if(name == "large_share" && real >= 0 && real <= 1)
+            spec.large_share = real;
+        else if(name == "device_requests" && real >= 0)
+            spec.device_requests = real;
+        else if(name == "printer_share" && real >= 0 && real <= 1)
+            spec.printer_share = real;
+        else if(name == "file_size" && two && a > 0) {
+            spec.min_file_size = a;
+            spec.max_file_size = b;
+        }
+        else if(name == "burst" && two && a > 0) {
+            spec.min_burst = a;
+            spec.max_burst = b;
+        }
+        else if(name == "files" && one && a > 0)
+            spec.files = a;
+        else if(name == "setup" && count >= 4 && count <= 7 && lexer::parse_uint(tokens[1], spec.memory)
+                && lexer::parse_uint(tokens[2], spec.printers) && lexer::parse_uint(tokens[3], spec.disks)
+                && (count < 5 || parse_placement(tokens[4].text, tokens[4].length, spec.placement))
+                && (count < 6 || parse_scheduling(tokens[5].text, tokens[5].length, spec.scheduling))
+                && (count < 7 || (lexer::parse_uint(tokens[6], spec.cores) && spec.cores > 0)))
+            continue;
+        else
+            return false;
+    }
+    return true;
+}
+
+/*
+ workload_generator
+
+ Draws processes from a spec, the same seed always gives the same stream
+ Uses its own xorshift generator and distributions, because the std distributions
+ are free to differ between standard libraries
+ Arrivals are a Poisson process, the number of device requests of a process is
+ geometric with the spec's mean, cut off at max_requests, and files, sizes and bursts are uniform
+ */
+class workload_generator {
+public:
+    //Most device requests the simulator reads from one workload line
+    static const unsigned int max_requests = 8;
+    struct request {
+        char kind;
+        unsigned int device, file, file_size, burst;
+    };
+    struct process {
+        unsigned long long time;
+        unsigned int memory, priority, burst;
+        std::vector<request> requests;
+    };
+
+private:
+    workload_spec spec;
+    uint64_t state;
+    double clock = 0;
+    //Cumulative weights of zipf ranks for memory sizes and priorities
+    std::vector<double> size_weights, priority_weights;
+
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 2685821657736338717ull;
+    }
+    //Uniform in [0, 1)
+    double real() {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+    //Uniform in [low, high]
+    unsigned int between(unsigned int low, unsigned int high) {
+        return low + (unsigned int)(real() * ((double)high - low + 1));
+    }
+    static std::vector<double> zipf_weights(unsigned int ranks, double exponent) {
+        std::vector<double> weights(ranks);
+        double total = 0;
+        for (unsigned int k = 0; k < ranks; k++) {
+            total += 1.0 / std::pow(k + 1.0, exponent);
+            weights[k] = total;
+        }
+        return weights;
+    }
+    //Rank drawn from cumulative weights, 0 is the most likely
+    unsigned int zipf(const std::vector<double>& weights) {
+        double u = real() * weights.back();
+        return (unsigned int)(std::upper_bound(weights.begin(), weights.end(), u) - weights.begin());
+    }
+    unsigned int memory_size() {
+        unsigned int low = spec.min_memory, high = spec.max_memory;
+        switch (spec.sizes) {
+            case zipf_sizes:
+                return low + zipf(size_weights);
+            case bimodal_sizes: {
+                unsigned int quarter = (high - low) / 4;
+                if(real() < spec.large_share)
+                    return between(high - quarter, high);
+                return between(low, low + quarter);
+            }
+            default:
+                return between(low, high);
+        }
+    }
+
+public:
+    workload_generator(const workload_spec& spec) : spec(spec), state(spec.seed * 0x9e3779b97f4a7c15ull + 1) {
+        if(spec.sizes == zipf_sizes)
+            size_weights = zipf_weights(spec.max_memory - spec.min_memory + 1, spec.size_skew);
+        if(spec.priority_skew > 0)
+            priority_weights = zipf_weights(spec.priorities, spec.priority_skew);
+    }
+    const workload_spec& settings() const {
+        return spec;
+    }
+    //Next process in arrival order
+    process next_process() {
+        process p;
+        clock += -std::log(1.0 - real()) / spec.arrival_rate;
+        p.time = (unsigned long long)clock;
+        p.memory = memory_size();
+        p.priority = spec.priority_skew > 0 ? zipf(priority_weights) : between(0, spec.priorities - 1);
+        p.burst = between(spec.min_burst, spec.max_burst);
+        //Geometric number of requests with mean device_requests
+        double more = spec.device_requests / (1.0 + spec.device_requests);
+        while (p.requests.size() < max_requests && real() < more) {
+            request r;
+            bool printer = (spec.disks == 0 || real() < spec.printer_share) && spec.printers > 0;
+            if(!printer && spec.disks == 0)
+                break;
+            r.kind = printer ? 'p' : 'd';
+            r.device = between(1, printer ? spec.printers : spec.disks);
+            r.file = between(1, spec.files);
+            r.file_size = between(spec.min_file_size, spec.max_file_size);
+            r.burst = between(spec.min_burst, spec.max_burst);
+            p.requests.push_back(r);
+        }
+        return p;
+    }
+    //Setup line shared by workloads and traces
+    void write_setup(std::ostream& out) const {
+        out << spec.memory << ' ' << spec.printers << ' ' << spec.disks << ' '
+        << placement_name(spec.placement) << ' ' << scheduling_name(spec.scheduling) << ' ' << spec.cores << '\n';
+    }
+    //Simulation workload, one process per line
+    void write_workload(std::ostream& out) {
+        write_setup(out);
+        for (unsigned int i = 0; i < spec.processes; i++) {
+            process p = next_process();
+            out << p.time << ' ' << p.memory << ' ' << p.priority << ' ' << p.burst;
+            for (size_t j = 0; j < p.requests.size(); j++) {
+                const request& r = p.requests[j];
+                out << ' ' << r.kind << r.device << " file" << r.file << ".dat " << r.file_size << ' ' << r.burst;
+            }
+            out << '\n';
+        }
+    }
+    /*
+     Batch trace with the same mix
+     Every process is created with A, its device requests are sent with p and d and
+     completed with P and D a few commands later, and it is terminated with t
+     Which process each command hits is up to the scheduler, as with a hand written trace
+     */
+    void write_trace(std::ostream& out) {
+        write_setup(out);
+        std::vector<request> outstanding;
+        for (unsigned int i = 0; i < spec.processes; i++) {
+            process p = next_process();
+            out << "A " << p.memory << ' ' << p.priority << '\n';
+            for (size_t j = 0; j < p.requests.size(); j++) {
+                const request& r = p.requests[j];
+                out << r.kind << r.device << " file" << r.file << ".dat " << r.file_size << '\n';
+                outstanding.push_back(r);
+            }
+            //Complete some of the outstanding requests, oldest first
+            size_t done = outstanding.empty() ? 0 : between(0, (unsigned int)outstanding.size());
+            for (size_t j = 0; j < done; j++)
+                out << (char)(outstanding[j].kind == 'p' ? 'P' : 'D') << outstanding[j].device << '\n';
+            outstanding.erase(outstanding.begin(), outstanding.begin() + done);
+            out << "t\n";
+        }
+        for (size_t j = 0; j < outstanding.size(); j++)
+            out << (char)(outstanding[j].kind == 'p' ? 'P' : 'D') << outstanding[j].device << '\n';
+    }
+};
+
+#endif /* workload_h */
@@ -0,0 +1,250 @@
+//
+//  bench_suite.cpp
+//  PCB
+//  CSCI 340 Project
+//
+//  Runs the memory allocator, the ready queues and the whole os against one
+//  seeded synthetic workload and reports throughput, p50 and p99 latency and peak RSS
+//  Every operation is timed on its own, so latencies include the cost of reading the clock
+//  Peak RSS is the high water mark of the process so far, so it only grows down the table
+//
+//  Build: cmake -S . -B build && cmake --build build --target bench_suite
+//  Usage: bench_suite [spec] [--seed n] [--processes n] [--sizes uniform|zipf|bimodal]
+//
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <queue>
+#include <chrono>
+#include <sys/resource.h>
+#include "../PCB/os.h"
+#include "../PCB/workload.h"
+#include "../PCB/instrument.h"
+
+using namespace std;
+
+//Largest resident set of the process so far in KB
+long peak_rss() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+//Nanoseconds since start
+uint64_t elapsed(chrono::steady_clock::time_point start) {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+}
+
+//One table row
+void report(const string& name, const latency_histogram& latency, double seconds) {
+    cout << setw(22) << left << name
+    << setw(12) << left << latency.count()
+    << setw(14) << left << fixed << setprecision(0) << (seconds > 0 ? latency.count() / seconds : 0.0)
+    << setw(10) << left << latency.percentile(0.5)
+    << setw(10) << left << latency.percentile(0.99)
+    << peak_rss() << '\n';
+}
+
+/*
+ Memory
+
+ Allocate every process on arrival and free it once its bursts would be done,
+ as if it ran alone on the CPU
+ A process that does not fit is rejected, like the os does
+ */
+void bench_memory(placement_policy placement, const vector<workload_generator::process>& processes, unsigned int cap) {
+    typedef pair<unsigned long long, pid_t> departure;
+    priority_queue<departure, vector<departure>, greater<departure> > live;
+    memory_manager* m = make_memory(placement, cap);
+    latency_histogram latency;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t i = 0; i < processes.size(); i++) {
+        const workload_generator::process& p = processes[i];
+        while (!live.empty() && live.top().first <= p.time) {
+            chrono::steady_clock::time_point op = chrono::steady_clock::now();
+            m->deallocate_memory(live.top().second);
+            latency.record(elapsed(op));
+            live.pop();
+        }
+        unsigned long long run = p.burst;
+        for (size_t j = 0; j < p.requests.size(); j++)
+            run += p.requests[j].burst;
+        chrono::steady_clock::time_point op = chrono::steady_clock::now();
+        int base = m->allocate_memory((pid_t)i+1, p.memory);
+        latency.record(elapsed(op));
+        if(base >= 0)
+            live.push(departure(p.time + run, (pid_t)i+1));
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    delete m;
+    report(string("memory ") + placement_name(placement), latency, seconds);
+}
+
+/*
+ Ready queue
+
+ One core dispatching the arrivals for a time slice at a time
+ The top is popped, charged for what it ran and pushed back if its burst is not done,
+ every push and pop is timed
+ */
+void bench_ready_queue(scheduling_policy scheduling, const vector<workload_generator::process>& processes, unsigned int slice) {
+    process_pool pcbs;
+    scheduler* ready_queue = make_scheduler(scheduling, pcbs, slice);
+    latency_histogram latency;
+    unsigned long long clock = 0;
+    size_t next = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    while (next < processes.size() || !ready_queue->empty()) {
+        //Queue everything that arrived while the last slice ran
+        while (next < processes.size() && (processes[next].time <= clock || ready_queue->empty())) {
+            const workload_generator::process& p = processes[next++];
+            process_handle h = pcbs.acquire();
+            pcbs.pid[h] = (pid_t)next;
+            pcbs.priority[h] = p.priority;
+            pcbs.burst_left[h] = p.burst;
+            if(clock < p.time)
+                clock = p.time;
+            chrono::steady_clock::time_point op = chrono::steady_clock::now();
+            ready_queue->admit(h);
+            ready_queue->push(h);
+            latency.record(elapsed(op));
+        }
+        chrono::steady_clock::time_point op = chrono::steady_clock::now();
+        process_handle h = ready_queue->top();
+        ready_queue->pop();
+        latency.record(elapsed(op));
+        unsigned long long ran = pcbs.burst_left[h], limit = ready_queue->quantum(h);
+        if(limit && limit < ran)
+            ran = limit;
+        clock += ran;
+        pcbs.burst_left[h] -= ran;
+        ready_queue->charge(h, ran);
+        if(pcbs.burst_left[h] == 0) {
+            pcbs.release(h);
+            continue;
+        }
+        op = chrono::steady_clock::now();
+        ready_queue->expire(h);
+        ready_queue->push(h);
+        latency.record(elapsed(op));
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    delete ready_queue;
+    report(string("ready queue ") + scheduling_name(scheduling), latency, seconds);
+}
+
+//Whole command loop, every line of the trace is lexed, parsed and executed and the three are timed together
+void bench_commands(const string& trace) {
+    os sim;
+    sim.set_quiet();
+    text_buffer buffer(trace);
+    istream in(&buffer);
+    string line;
+    const size_t max_tokens = 8;
+    token tokens[max_tokens];
+    getline(in, line);
+    if(!sim.setup(tokens, lexer::tokenize(line.data(), line.size(), tokens, max_tokens))) {
+        cout << "ERROR: Invalid setup line " << line << '\n';
+        return;
+    }
+    latency_histogram latency;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    while (getline(in, line)) {
+        chrono::steady_clock::time_point op = chrono::steady_clock::now();
+        size_t count = lexer::tokenize(line.data(), line.size(), tokens, max_tokens);
+        command c;
+        if(count > 0 && sim.parse(tokens, count, c))
+            sim.execute(c);
+        latency.record(elapsed(op));
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    report("os commands", latency, seconds);
+}
+
+//Event driven simulation of the workload, throughput is events per second
+//Events are not timed one by one, so the percentiles are left out
+void bench_simulation(const string& workload) {
+    os sim;
+    sim.set_quiet();
+    text_buffer buffer(workload);
+    istream in(&buffer);
+    string line;
+    const size_t max_tokens = 8;
+    token tokens[max_tokens];
+    getline(in, line);
+    if(!sim.setup(tokens, lexer::tokenize(line.data(), line.size(), tokens, max_tokens))) {
+        cout << "ERROR: Invalid setup line " << line << '\n';
+        return;
+    }
+    double seconds = sim.simulate(in);
+    sweep_point point = {};
+    unsigned long long events = sim.result(0, point, seconds).events;
+    cout << setw(22) << left << "os simulation"
+    << setw(12) << left << events
+    << setw(14) << left << fixed << setprecision(0) << (seconds > 0 ? events / seconds : 0.0)
+    << setw(10) << left << "-"
+    << setw(10) << left << "-"
+    << peak_rss() << '\n';
+}
+
+int main(int argc, const char * argv[]) {
+    workload_spec spec;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        unsigned int value;
+        if(arg == "--seed" && i+1 < argc && lexer::parse_uint(string(argv[i+1]), value)) {
+            spec.seed = value;
+            i++;
+        }
+        else if(arg == "--processes" && i+1 < argc && lexer::parse_uint(string(argv[i+1]), spec.processes))
+            i++;
+        else if(arg == "--sizes" && i+1 < argc && parse_size_distribution(argv[i+1], string(argv[i+1]).size(), spec.sizes))
+            i++;
+        else if(arg[0] != '-') {
+            ifstream file(argv[i]);
+            size_t line = 0;
+            if(!file || !parse_workload_spec(file, spec, line)) {
+                cerr << "ERROR: Invalid workload spec " << arg << " at line " << line << endl;
+                return 1;
+            }
+        }
+        else {
+            cerr << "Usage: bench_suite [spec] [--seed n] [--processes n] [--sizes uniform|zipf|bimodal]" << endl;
+            return 1;
+        }
+    }
+
+    //Every phase sees the same stream
+    vector<workload_generator::process> processes;
+    workload_generator generator(spec);
+    for (unsigned int i = 0; i < spec.processes; i++)
+        processes.push_back(generator.next_process());
+    ostringstream workload, trace;
+    workload_generator(spec).write_workload(workload);
+    workload_generator(spec).write_trace(trace);
+
+    cout << "Seed: " << spec.seed << " Processes: " << spec.processes << " Sizes: " << size_distribution_name(spec.sizes)
+    << " Memory: " << spec.memory << '\n';
+    cout << setw(22) << left << "Benchmark"
+    << setw(12) << left << "Ops"
+    << setw(14) << left << "Ops/sec"
+    << setw(10) << left << "p50 ns"
+    << setw(10) << left << "p99 ns"
+    << "Peak RSS KB" << '\n';
+    for (int i = 0; i < 5; i++)
+        bench_memory((placement_policy)i, processes, spec.memory);
+    for (int i = 0; i < 5; i++)
+        bench_ready_queue((scheduling_policy)i, processes, 4);
+    bench_commands(trace.str());
+    bench_simulation(workload.str());
+    cout.flush();
+    return 0;
+}
@@ -0,0 +1,123 @@
+//
+//  lexer_bench.cpp
+//  PCB
+//  CSCI 340 Project
+//
+//  Compares the hand written lexer against the old regex validation
+//  on a generated corpus and checks both accept the same tokens,
+//  apart from the h snapshot the lexer has accepted since histograms were added
+//
+//  Build: g++ -std=c++11 -O2 bench/lexer_bench.cpp -o lexer_bench
+//  Usage: lexer_bench [tokens]
+//
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <regex>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include "../PCB/lexer.h"
+
+using namespace std;
+
+//Regular expressions the simulator used before the lexer
+const regex r_int("[0-9]*");
+const regex r_command("[hpPdD][1-9][0-9]*|[AtS]");
+const regex r_snapshot("[rim]");
+const regex r_string("[a-zA-Z_][a-zA-Z_0-9]*\\.[a-zA-Z0-9]+");
+
+//Build a mix of valid and invalid tokens for every grammar rule
+vector<string> make_corpus(size_t size, unsigned int seed) {
+    const string alphabet = "AtSphPdDrimx0123456789_.aZ";
+    const char* samples[] = {"A", "t", "S", "p1", "P12", "d3", "D40", "h7", "p0", "A1", "x",
+        "0", "42", "4096", "12a", "", "r", "i", "m", "h", "rm",
+        "report.txt", "a.b", "_x9.c", "9a.txt", "a.", "a..b", ".txt"};
+    const size_t num_samples = sizeof(samples)/sizeof(samples[0]);
+    mt19937 rng(seed);
+    vector<string> corpus;
+    corpus.reserve(size);
+    for (size_t i = 0; i < size; i++) {
+        if(rng() % 4) {
+            corpus.push_back(samples[rng() % num_samples]);
+        } else {
+            //Random token to hit the less common paths
+            string s;
+            size_t length = 1 + rng() % 8;
+            for (size_t j = 0; j < length; j++)
+                s += alphabet[rng() % alphabet.size()];
+            corpus.push_back(s);
+        }
+    }
+    return corpus;
+}
+
+//Time one validator over the corpus, returns ns per token
+template <class validator>
+double time_validator(const vector<string>& corpus, validator valid, size_t& accepted) {
+    accepted = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t i = 0; i < corpus.size(); i++)
+        if(valid(corpus[i]))
+            accepted++;
+    chrono::steady_clock::time_point end = chrono::steady_clock::now();
+    return chrono::duration<double, nano>(end-start).count() / corpus.size();
+}
+
+struct regex_validator {
+    const regex& r;
+    bool operator()(const string& s) const { return regex_match(s, r); }
+};
+struct lexer_validator {
+    bool (*valid)(const string&);
+    bool operator()(const string& s) const { return valid(s); }
+};
+
+int main(int argc, const char * argv[]) {
+    size_t size = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+    vector<string> corpus = make_corpus(size, 340);
+
+    //added is the one token the lexer accepts on top of the old regex, if any
+    struct rule {
+        const char* name;
+        const regex& r;
+        bool (*valid)(const string&);
+        const char* added;
+    } rules[] = {
+        {"int", r_int, lexer::is_int, nullptr},
+        {"command", r_command, lexer::is_command, nullptr},
+        {"snapshot", r_snapshot, lexer::is_snapshot, "h"},
+        {"file name", r_string, lexer::is_file_name, nullptr},
+    };
+
+    //Both paths must agree on every token before timings mean anything
+    for (const rule& r : rules) {
+        for (size_t i = 0; i < corpus.size(); i++) {
+            bool expected = regex_match(corpus[i], r.r) || (r.added && corpus[i] == r.added);
+            if(expected != r.valid(corpus[i])) {
+                cout << "MISMATCH: " << r.name << " \"" << corpus[i] << "\"" << endl;
+                return 1;
+            }
+        }
+    }
+
+    cout << "Tokens: " << corpus.size() << '\n';
+    cout << setw(12) << left << "Rule"
+    << setw(10) << left << "Accepted"
+    << setw(14) << left << "regex ns/tok"
+    << setw(14) << left << "lexer ns/tok"
+    << "Speedup" << '\n';
+    for (const rule& r : rules) {
+        size_t regex_accepted, lexer_accepted;
+        double regex_ns = time_validator(corpus, regex_validator{r.r}, regex_accepted);
+        double lexer_ns = time_validator(corpus, lexer_validator{r.valid}, lexer_accepted);
+        cout << setw(12) << left << r.name
+        << setw(10) << left << lexer_accepted
+        << setw(14) << left << fixed << setprecision(2) << regex_ns
+        << setw(14) << left << lexer_ns
+        << setprecision(1) << regex_ns/lexer_ns << "x" << '\n';
+    }
+    return 0;
+}
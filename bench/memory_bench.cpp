@@ -0,0 +1,289 @@
+//
+//  memory_bench.cpp
+//  PCB
+//  CSCI 340 Project
+//
+//  Randomized allocate and free traffic against every placement policy
+//  The hole index is first checked against a plain scan of the same holes
+//  A checked pass keeps a shadow copy of the live allocations and stops on the first
+//  overlap, out of bounds range or free space that does not add up,
+//  then an unchecked pass over the same traffic is timed
+//
+//  Build: g++ -std=c++11 -O2 bench/memory_bench.cpp -o memory_bench
+//  Usage: memory_bench [operations] [memory]
+//
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include "../PCB/memory.h"
+
+using namespace std;
+
+struct run_result {
+    size_t allocations = 0, frees = 0;
+    unsigned int peak_holes = 0;
+    memory_stats stats;
+    double ns_per_op = 0;
+};
+
+/*
+ shadow
+
+ What the bench expects memory to look like, live ranges keyed by base
+ Ranges cover the whole reserved block, so a buddy block rounded up is checked too
+ */
+struct shadow {
+    struct block {
+        unsigned int end;
+        pid_t pid;
+    };
+    map<unsigned int, block> blocks;
+    map<pid_t, unsigned int> base_of;
+    unsigned long long reserved = 0;
+
+    //Add block [base, end), returns false if it overlaps one already there
+    bool insert(pid_t pid, unsigned int base, unsigned int end) {
+        map<unsigned int, block>::iterator next = blocks.lower_bound(base);
+        if(next != blocks.end() && next->first < end)
+            return false;
+        if(next != blocks.begin() && prev(next)->second.end > base)
+            return false;
+        blocks[base] = block{end, pid};
+        base_of[pid] = base;
+        reserved += end-base;
+        return true;
+    }
+    void erase(pid_t pid) {
+        map<unsigned int, block>::iterator b = blocks.find(base_of[pid]);
+        reserved -= b->second.end - b->first;
+        blocks.erase(b);
+        base_of.erase(pid);
+    }
+};
+
+//Report a broken invariant, always returns false
+bool fail(const char* name, size_t op, const string& what) {
+    cout << "FAILED: " << name << " operation " << op << ": " << what << endl;
+    return false;
+}
+
+//Allocator's own view of the allocations must match the shadow
+template <class placement>
+bool same_allocations(const memory<placement>& m, const shadow& s, const placement& policy) {
+    size_t count = 0;
+    bool same = true;
+    m.for_each_allocation([&](const memory_range& range) {
+        count++;
+        map<pid_t, unsigned int>::const_iterator base = s.base_of.find(range.pid);
+        if(base == s.base_of.end() || base->second != range.base
+           || s.blocks.at(base->second).end != range.base + policy.block_size(range.limit-range.base+1))
+            same = false;
+    });
+    return same && count == s.base_of.size();
+}
+
+/*
+ run
+
+ Runs operations random requests against memory of size cap
+ About half the requests allocate, the rest free a random live allocation
+ Sizes are mostly small with the odd large one, so holes of all sizes build up
+ With compacting, a request that fails while enough memory is free compacts and retries,
+ and it only counts as failed if the retry fails too
+ With checking, every operation is checked against the shadow, so the timing is meaningless
+ */
+template <class placement>
+bool run(const char* name, size_t operations, unsigned int cap, bool compacting, bool checking, run_result& r) {
+    memory<placement> m(cap);
+    placement policy;
+    shadow s;
+    vector<pid_t> live;
+    vector<memory_range> moved;
+    mt19937 rng(340);
+    pid_t next_pid = 1;
+    unsigned int small = max(1u, cap/256), large = max(1u, cap/16);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t op = 0; op < operations; op++) {
+        if(live.empty() || rng() % 2) {
+            unsigned int amount = 1 + rng() % (rng() % 8 ? small : large);
+            pid_t pid = next_pid++;
+            int base = m.allocate_memory(pid, amount, compacting);
+            if(base < 0 && compacting) {
+                moved.clear();
+                if(m.stats().free >= policy.block_size(amount) && m.compact(moved)) {
+                    for (size_t i = 0; i < moved.size() && checking; i++)
+                        s.erase(moved[i].pid);
+                    for (size_t i = 0; i < moved.size() && checking; i++)
+                        if(!s.insert(moved[i].pid, moved[i].base, moved[i].base + policy.block_size(moved[i].limit-moved[i].base+1)))
+                            return fail(name, op, "compaction moved pid " + to_string(moved[i].pid) + " onto another allocation");
+                }
+                //Only a failed retry counts
+                base = m.allocate_memory(pid, amount);
+            }
+            if(base >= 0) {
+                live.push_back(pid);
+                r.allocations++;
+                if(checking) {
+                    unsigned int end = base + policy.block_size(amount);
+                    if(end > cap || end < (unsigned int)base)
+                        return fail(name, op, "block " + to_string(base) + "-" + to_string(end) + " is outside memory");
+                    if(!s.insert(pid, base, end))
+                        return fail(name, op, "block " + to_string(base) + "-" + to_string(end) + " overlaps another allocation");
+                }
+            }
+        } else {
+            size_t i = rng() % live.size();
+            pid_t pid = live[i];
+            live[i] = live.back();
+            live.pop_back();
+            if(!m.deallocate_memory(pid))
+                return fail(name, op, "pid " + to_string(pid) + " was not allocated");
+            r.frees++;
+            if(checking)
+                s.erase(pid);
+        }
+        if(checking) {
+            memory_stats stats = m.stats();
+            //Free space is conserved
+            if(stats.free + s.reserved != cap)
+                return fail(name, op, "free " + to_string(stats.free) + " + reserved " + to_string(s.reserved) + " != " + to_string(cap));
+            //Holes and free space agree
+            if(stats.largest_hole > stats.free || (stats.holes == 0) != (stats.free == 0))
+                return fail(name, op, to_string(stats.holes) + " holes, largest " + to_string(stats.largest_hole) + ", free " + to_string(stats.free));
+            r.peak_holes = max(r.peak_holes, stats.holes);
+            if((op % 4096 == 0 || op+1 == operations) && !same_allocations(m, s, policy))
+                return fail(name, op, "allocations differ from the shadow");
+        }
+    }
+    chrono::steady_clock::time_point end = chrono::steady_clock::now();
+    r.ns_per_op = chrono::duration<double, nano>(end-start).count() / operations;
+    r.stats = m.stats();
+    return true;
+}
+
+/*
+ check_hole_index
+
+ Drives a hole_index directly with random takes and releases and compares every query
+ with a scan of a plain map of the same holes
+ first_fit, first_fit_from, best_fit and largest must find exactly the hole the scan finds
+ */
+bool check_hole_index(size_t operations, unsigned int cap) {
+    const char* name = "hole index";
+    hole_index index(true);
+    map<unsigned int, unsigned int> holes;
+    vector<pair<unsigned int, unsigned int> > taken;
+    mt19937 rng(3403);
+    unsigned int small = max(1u, cap/256), large = max(1u, cap/16);
+    index.insert(0, cap);
+    holes[0] = cap;
+
+    for (size_t op = 0; op < operations; op++) {
+        unsigned int amount = 1 + rng() % (rng() % 8 ? small : large);
+        unsigned int address = rng() % cap;
+        //Scans
+        hole_index::hole first = {0, 0}, from = {0, 0}, best = {0, 0}, largest = {0, 0};
+        for (map<unsigned int, unsigned int>::const_iterator i = holes.begin(); i != holes.end(); i++) {
+            if(i->second >= amount && first.size == 0)
+                first = hole_index::hole{i->first, i->second};
+            if(i->second >= amount && i->first >= address && from.size == 0)
+                from = hole_index::hole{i->first, i->second};
+            if(i->second >= amount && (best.size == 0 || i->second < best.size))
+                best = hole_index::hole{i->first, i->second};
+            if(i->second > largest.size)
+                largest = hole_index::hole{i->first, i->second};
+        }
+        hole_index::hole found[] = {index.first_fit(amount), index.first_fit_from(address, amount), index.best_fit(amount), index.largest()};
+        hole_index::hole expected[] = {first, from, best, largest};
+        const char* queries[] = {"first_fit", "first_fit_from", "best_fit", "largest"};
+        for (int q = 0; q < 4; q++)
+            if(found[q].size != expected[q].size || (expected[q].size && found[q].base != expected[q].base))
+                return fail(name, op, string(queries[q]) + " found " + to_string(found[q].base) + "+" + to_string(found[q].size)
+                            + ", scan found " + to_string(expected[q].base) + "+" + to_string(expected[q].size));
+        if(index.size() != holes.size() || index.largest_size() != largest.size)
+            return fail(name, op, to_string(index.size()) + " holes indexed, " + to_string(holes.size()) + " in the scan");
+
+        if(taken.empty() || rng() % 2) {
+            //Take from whichever hole one of the queries found
+            hole_index::hole h = found[rng() % 4];
+            if(h.size < amount)
+                continue;
+            index.take(h.base, h.size, amount);
+            holes.erase(h.base);
+            if(h.size > amount)
+                holes[h.base+amount] = h.size-amount;
+            taken.push_back(make_pair(h.base, amount));
+        } else {
+            size_t i = rng() % taken.size();
+            unsigned int base = taken[i].first, size = taken[i].second;
+            taken[i] = taken.back();
+            taken.pop_back();
+            index.release(base, size);
+            map<unsigned int, unsigned int>::iterator next = holes.find(base+size);
+            if(next != holes.end()) {
+                size += next->second;
+                holes.erase(next);
+            }
+            map<unsigned int, unsigned int>::iterator previous = holes.lower_bound(base);
+            if(previous != holes.begin() && (--previous)->first + previous->second == base)
+                previous->second += size;
+            else
+                holes[base] = size;
+        }
+    }
+    cout << "Hole index: " << operations << " operations match a scan" << '\n';
+    return true;
+}
+
+//Checked pass, then timed pass, then one table row
+template <class placement>
+bool bench(const char* name, size_t operations, unsigned int cap, bool compacting) {
+    run_result checked, timed;
+    if(!run<placement>(name, operations, cap, compacting, true, checked))
+        return false;
+    run<placement>(name, operations, cap, compacting, false, timed);
+    cout << setw(16) << left << name
+    << setw(10) << left << fixed << setprecision(1) << timed.ns_per_op
+    << setw(12) << left << timed.allocations
+    << setw(10) << left << timed.stats.failures
+    << setw(13) << left << timed.stats.compactions
+    << setw(12) << left << checked.peak_holes
+    << setprecision(3) << timed.stats.external_fragmentation() << '\n';
+    return true;
+}
+
+int main(int argc, const char * argv[]) {
+    size_t operations = argc > 1 ? strtoul(argv[1], nullptr, 10) : 2000000;
+    unsigned int cap = argc > 2 ? (unsigned int)strtoul(argv[2], nullptr, 10) : 1u << 20;
+    if(operations == 0 || cap == 0) {
+        cout << "Usage: memory_bench [operations] [memory]" << endl;
+        return 1;
+    }
+
+    cout << "Operations: " << operations << " Memory: " << cap << '\n';
+    //Every query is checked against a full scan, so the index check runs fewer operations
+    if(!check_hole_index(min(operations, (size_t)200000), cap))
+        return 1;
+    cout << setw(16) << left << "Policy"
+    << setw(10) << left << "ns/op"
+    << setw(12) << left << "Allocated"
+    << setw(10) << left << "Failed"
+    << setw(13) << left << "Compactions"
+    << setw(12) << left << "Peak holes"
+    << "Fragmentation" << '\n';
+    bool ok = bench<first_fit>("first", operations, cap, false)
+    && bench<best_fit>("best", operations, cap, false)
+    && bench<worst_fit>("worst", operations, cap, false)
+    && bench<next_fit>("next", operations, cap, false)
+    && bench<buddy>("buddy", operations, cap, false)
+    && bench<first_fit>("first+compact", operations, cap, true)
+    && bench<best_fit>("best+compact", operations, cap, true);
+    return ok ? 0 : 1;
+}
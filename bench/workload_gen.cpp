@@ -0,0 +1,58 @@
+//
+//  workload_gen.cpp
+//  PCB
+//  CSCI 340 Project
+//
+//  Writes a seeded synthetic workload for -s, or a batch trace for -b, to stdout
+//  The same spec and seed always give the same bytes
+//
+//  Build: g++ -std=c++11 -O2 bench/workload_gen.cpp -o workload_gen
+//  Usage: workload_gen [spec] [--trace] [--seed n] [--processes n] [--sizes uniform|zipf|bimodal]
+//
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include "../PCB/workload.h"
+
+using namespace std;
+
+int main(int argc, const char * argv[]) {
+    workload_spec spec;
+    bool trace = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        unsigned int value;
+        if(arg == "--trace")
+            trace = true;
+        else if(arg == "--seed" && i+1 < argc && lexer::parse_uint(string(argv[i+1]), value)) {
+            spec.seed = value;
+            i++;
+        }
+        else if(arg == "--processes" && i+1 < argc && lexer::parse_uint(string(argv[i+1]), spec.processes))
+            i++;
+        else if(arg == "--sizes" && i+1 < argc && parse_size_distribution(argv[i+1], string(argv[i+1]).size(), spec.sizes))
+            i++;
+        else if(arg[0] != '-') {
+            //Flags after the spec file override it
+            ifstream file(argv[i]);
+            size_t line = 0;
+            if(!file || !parse_workload_spec(file, spec, line)) {
+                cerr << "ERROR: Invalid workload spec " << arg << " at line " << line << endl;
+                return 1;
+            }
+        }
+        else {
+            cerr << "Usage: workload_gen [spec] [--trace] [--seed n] [--processes n] [--sizes uniform|zipf|bimodal]" << endl;
+            return 1;
+        }
+    }
+
+    workload_generator generator(spec);
+    if(trace)
+        generator.write_trace(cout);
+    else
+        generator.write_workload(cout);
+    cout.flush();
+    return 0;
+}